@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 24 Oct 2026 11:20:08am
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+// Turns a recording into a partial track file the plugin plays:
+//
+//   Analyzer --input=sound.wav --output=sound.aptf [--partials=256]
+//            [--fundamental=Hz] [--threshold=-80] [--fft-order=12] [--overlap=4]
+//
+// Channels are mixed to mono. Without --fundamental the lowest strong peak
+// of the loudest frame is taken, the ratios in the file are relative to it,
+// so a note at that frequency plays the recording at its own pitch.
+
+#include <JuceHeader.h>
+#include <memory>
+#include "../../Source/PartialAnalyzer.h"
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+    ArgumentList args(argc, argv);
+
+    if (args.containsOption("--help|-h") || !args.containsOption("--input") || !args.containsOption("--output"))
+    {
+        std::cout << "Analyzer --input=sound.wav --output=sound.aptf [--partials=256]\n"
+                     "         [--fundamental=Hz] [--threshold=-80] [--fft-order=12] [--overlap=4]\n";
+        return args.containsOption("--help|-h") ? 0 : 1;
+    }
+
+    File input = args.getFileForOption("--input");
+    File output = args.getFileForOption("--output");
+
+    AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    unique_ptr<AudioFormatReader> reader(formats.createReaderFor(input));
+    if (reader == nullptr)
+    {
+        std::cerr << "Could not read " << input.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    int numSamples = (int)reader->lengthInSamples;
+    int numChannels = (int)reader->numChannels;
+    AudioBuffer<float> sound(numChannels, numSamples);
+    reader->read(&sound, 0, numSamples, 0, true, true);
+
+    // mono, the channels averaged
+    for (int channel = 1; channel < numChannels; channel++)
+        sound.addFrom(0, 0, sound, channel, 0, numSamples);
+    if (numChannels > 1)
+        sound.applyGain(0, 0, numSamples, 1.f / numChannels);
+
+    PartialAnalyzer::Options options;
+    if (args.containsOption("--partials"))
+        options.maxPartials = jlimit(1, 4096, args.getValueForOption("--partials").getIntValue());
+    if (args.containsOption("--fundamental"))
+        options.fundamental = args.getValueForOption("--fundamental").getDoubleValue();
+    if (args.containsOption("--threshold"))
+        options.thresholdDb = args.getValueForOption("--threshold").getFloatValue();
+    if (args.containsOption("--fft-order"))
+        options.fftOrder = jlimit(8, 16, args.getValueForOption("--fft-order").getIntValue());
+    if (args.containsOption("--overlap"))
+        options.overlap = jlimit(1, 16, args.getValueForOption("--overlap").getIntValue());
+
+    PartialAnalyzer analyzer(options);
+    PartialTracks tracks = analyzer.analyze(sound.getReadPointer(0), numSamples, reader->sampleRate);
+
+    if (!PartialTrackFile::write(output, tracks))
+    {
+        std::cerr << "Could not write " << output.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    std::cerr << tracks.getNumFrames() << " frames of " << tracks.numPartials << " partials at "
+              << tracks.frameRate << " frames per second, fundamental " << tracks.fundamental << " Hz" << std::endl;
+    return 0;
+}
@@ -0,0 +1,333 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 19 Oct 2026 2:31:50pm
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+// Headless benchmark of the synthesis engine. Sweeps voices x harmonics x
+// buffer size x sample rate and prints one row per combination:
+//
+//   Benchmark [--voices=1,8,32,128] [--harmonics=16,64,256] [--blocks=64,256,1024]
+//             [--rates=44100,48000,96000] [--engines=oscillators,fft]
+//             [--seconds=1] [--processor] [--format=csv|json] [--output=file]
+//
+// "voice" rows render SynthVoices directly on this thread, "processor" rows
+// (--processor) run the whole AdditiveSynthPluginAudioProcessor, with the
+// worker pool, the way a host would. Columns:
+//
+//   ns_per_sample          wall time per output sample, all voices
+//   ns_per_partial_sample  the same per sounding partial
+//   realtime_factor        processing time / audio time, below 1 keeps up
+//   worst_block_us         slowest block, compare with block_budget_us
+
+#include <JuceHeader.h>
+#include <vector>
+#include "../../Source/PluginProcessor.h"
+using namespace std;
+
+struct BenchmarkResult
+{
+    String target;
+    String engine;
+    int voices = 0;
+    int harmonics = 0;
+    int blockSize = 0;
+    double sampleRate = 0.0;
+    int64 partials = 0;             // sounding partials over all voices
+
+    double nsPerSample = 0.0;
+    double nsPerPartialSample = 0.0;
+    double realtimeFactor = 0.0;
+    double worstBlockUs = 0.0;
+    double blockBudgetUs = 0.0;
+};
+
+//==============================================================================
+// Low notes, so every harmonic of a 256 harmonic saw stays below nyquist at 44.1 kHz
+static double getNoteFrequency(int voice)
+{
+    return MidiMessage::getMidiNoteInHertz(28 + voice % 12);
+}
+
+// A MIDI note on a voice that holds it already releases that voice, so
+// through MIDI every voice plays a note of its own
+static int getMidiNote(int voice)
+{
+    return (28 + voice) % VoiceAllocator::numNotes;
+}
+
+// Partials of a saw below nyquist, what the voice renders
+static int countAudiblePartials(double frequency, int harmonics, double sampleRate)
+{
+    int partials = 0;
+    while (partials < harmonics && frequency * (partials + 1) < sampleRate / 2.0)
+        partials++;
+    return partials;
+}
+
+// Times numBlocks calls of renderBlock and fills in the timing columns
+template <typename RenderBlock>
+static void timeBlocks(BenchmarkResult& result, int numBlocks, RenderBlock&& renderBlock)
+{
+    int64 totalTicks = 0;
+    int64 worstTicks = 0;
+
+    for (int b = 0; b < numBlocks; b++)
+    {
+        int64 start = Time::getHighResolutionTicks();
+        renderBlock();
+        int64 ticks = Time::getHighResolutionTicks() - start;
+
+        totalTicks += ticks;
+        worstTicks = jmax(worstTicks, ticks);
+    }
+
+    double seconds = Time::highResolutionTicksToSeconds(totalTicks);
+    double numSamples = (double)numBlocks * result.blockSize;
+
+    result.nsPerSample = seconds * 1.0e9 / numSamples;
+    result.nsPerPartialSample = result.partials > 0 ? result.nsPerSample / result.partials : 0.0;
+    result.realtimeFactor = seconds / (numSamples / result.sampleRate);
+    result.worstBlockUs = Time::highResolutionTicksToSeconds(worstTicks) * 1.0e6;
+    result.blockBudgetUs = result.blockSize / result.sampleRate * 1.0e6;
+}
+
+//==============================================================================
+static BenchmarkResult benchmarkVoices(Voice::Engine engine, int voices, int harmonics,
+                                       int blockSize, double sampleRate, double seconds)
+{
+    BenchmarkResult result;
+    result.target = "voice";
+    result.engine = engine == Voice::inverseFFTEngine ? "fft" : "oscillators";
+    result.voices = voices;
+    result.harmonics = harmonics;
+    result.blockSize = blockSize;
+    result.sampleRate = sampleRate;
+
+    // same layout as the plugin, all voices in one arena
+    VoiceArena arena;
+    arena.allocate(voices * Voice::getMemorySize(harmonics, blockSize));
+
+    vector<Voice> synthVoices(voices);
+    Spectrum saw(PresetSpectra::get(PresetSpectra::saw).gains, harmonics);
+    for (int v = 0; v < voices; v++)
+    {
+        synthVoices[v].setup(sampleRate, harmonics, blockSize, &arena);
+        synthVoices[v].setNumHarmonics(harmonics);
+        synthVoices[v].setSpectrum(&saw);
+        synthVoices[v].setEngine(engine);
+        synthVoices[v].setADSRParams({ 0.001f, 0.1f, 1.0f, 0.5f });
+        synthVoices[v].setF0(getNoteFrequency(v));
+        synthVoices[v].noteOn();
+    }
+
+    vector<float> out(blockSize);
+    auto renderBlock = [&]
+    {
+        FloatVectorOperations::clear(out.data(), blockSize);
+        for (auto& voice : synthVoices)
+            voice.renderBlock(out.data(), blockSize);
+    };
+
+    // past the attack, with every partial list built
+    for (int b = 0; b < 8; b++)
+        renderBlock();
+
+    // the inverse FFT engine doesn't keep a partial list
+    for (int v = 0; v < voices; v++)
+        result.partials += engine == Voice::inverseFFTEngine ? countAudiblePartials(getNoteFrequency(v), harmonics, sampleRate)
+                                                             : synthVoices[v].getNumActivePartials();
+
+    timeBlocks(result, jmax(1, (int)(seconds * sampleRate / blockSize)), renderBlock);
+    return result;
+}
+
+//==============================================================================
+static void setParameter(AudioProcessor& processor, const String& id, float value)
+{
+    for (auto* parameter : processor.getParameters())
+        if (auto* ranged = dynamic_cast<RangedAudioParameter*>(parameter))
+            if (ranged->paramID == id)
+                ranged->setValueNotifyingHost(ranged->convertTo0to1(value));
+}
+
+static BenchmarkResult benchmarkProcessor(Voice::Engine engine, int voices, int harmonics,
+                                          int blockSize, double sampleRate, double seconds)
+{
+    BenchmarkResult result;
+    result.target = "processor";
+    result.engine = engine == Voice::inverseFFTEngine ? "fft" : "oscillators";
+    result.voices = jmin(voices, AdditiveSynthPluginAudioProcessor::maxVoices);
+    result.harmonics = harmonics;
+    result.blockSize = blockSize;
+    result.sampleRate = sampleRate;
+
+    AdditiveSynthPluginAudioProcessor processor;
+    processor.setPlayConfigDetails(0, 2, sampleRate, blockSize);
+    processor.prepareToPlay(sampleRate, blockSize);
+
+    AudioBuffer<float> buffer(2, blockSize);
+    MidiBuffer midi;
+
+#ifdef NOEDITOR
+    // Driven the way Unity does it: parameters, then notes through the event queue
+    processor.setNumVoices(result.voices);
+    setParameter(processor, "engine", (float)engine);
+    setParameter(processor, "harmonics", (float)harmonics);
+    setParameter(processor, "preset", (float)PresetSpectra::saw + 1.f);
+    setParameter(processor, "attack", 0.f);
+    for (int v = 0; v < result.voices; v++)
+    {
+        result.partials += countAudiblePartials(getNoteFrequency(v), harmonics, sampleRate);
+        processor.noteEvents.push({ 0.0, NoteEvent::noteOn, v % VoiceAllocator::numNotes, (float)getNoteFrequency(v), 1.f });
+    }
+    processor.processBlock(buffer, midi);
+#else
+    processor.setNumVoices(result.voices);
+    processor.setVoiceEngine(engine);
+    processor.setNumHarmonics(harmonics);
+    const PresetSpectrum& saw = PresetSpectra::get(PresetSpectra::saw);
+    copy(saw.gains, saw.gains + harmonics, processor.gainVector.begin());
+    processor.setVoiceHarmonics();
+    processor.setVoiceADSR(0.001f, 0.1f, 1.0f, 0.5f);
+
+    for (int v = 0; v < result.voices; v++)
+    {
+        result.partials += countAudiblePartials(MidiMessage::getMidiNoteInHertz(getMidiNote(v)), harmonics, sampleRate);
+        midi.addEvent(MidiMessage::noteOn(1, getMidiNote(v), 1.f), 0);
+    }
+    processor.processBlock(buffer, midi);
+    midi.clear();
+#endif
+
+    auto renderBlock = [&] { processor.processBlock(buffer, midi); };
+    for (int b = 0; b < 8; b++)
+        renderBlock();
+
+    timeBlocks(result, jmax(1, (int)(seconds * sampleRate / blockSize)), renderBlock);
+    processor.releaseResources();
+    return result;
+}
+
+//==============================================================================
+static String toCSV(const Array<BenchmarkResult>& results)
+{
+    String csv = "target,engine,voices,harmonics,block_size,sample_rate,partials,"
+                 "ns_per_sample,ns_per_partial_sample,realtime_factor,worst_block_us,block_budget_us\n";
+
+    for (auto& r : results)
+        csv << r.target << "," << r.engine << "," << r.voices << "," << r.harmonics << ","
+            << r.blockSize << "," << (int)r.sampleRate << "," << r.partials << ","
+            << String(r.nsPerSample, 3) << "," << String(r.nsPerPartialSample, 4) << ","
+            << String(r.realtimeFactor, 5) << "," << String(r.worstBlockUs, 2) << ","
+            << String(r.blockBudgetUs, 2) << "\n";
+
+    return csv;
+}
+
+static String toJSON(const Array<BenchmarkResult>& results)
+{
+    Array<var> rows;
+    for (auto& r : results)
+    {
+        auto* row = new DynamicObject();
+        row->setProperty("target", r.target);
+        row->setProperty("engine", r.engine);
+        row->setProperty("voices", r.voices);
+        row->setProperty("harmonics", r.harmonics);
+        row->setProperty("block_size", r.blockSize);
+        row->setProperty("sample_rate", r.sampleRate);
+        row->setProperty("partials", r.partials);
+        row->setProperty("ns_per_sample", r.nsPerSample);
+        row->setProperty("ns_per_partial_sample", r.nsPerPartialSample);
+        row->setProperty("realtime_factor", r.realtimeFactor);
+        row->setProperty("worst_block_us", r.worstBlockUs);
+        row->setProperty("block_budget_us", r.blockBudgetUs);
+        rows.add(var(row));
+    }
+
+    auto* report = new DynamicObject();
+    report->setProperty("cpu", SystemStats::getCpuModel());
+    report->setProperty("cores", SystemStats::getNumCpus());
+    report->setProperty("results", rows);
+    return JSON::toString(var(report));
+}
+
+// "1,8,32" or the defaults when the option is missing
+static Array<int> getList(const ArgumentList& args, const String& option, Array<int> defaults)
+{
+    if (!args.containsOption(option))
+        return defaults;
+
+    Array<int> values;
+    for (auto& value : StringArray::fromTokens(args.getValueForOption(option), ",", ""))
+        if (value.getIntValue() > 0)
+            values.add(value.getIntValue());
+    return values;
+}
+
+int main(int argc, char* argv[])
+{
+    ArgumentList args(argc, argv);
+
+    if (args.containsOption("--help|-h"))
+    {
+        std::cout << "Benchmark [--voices=1,8,32,128] [--harmonics=16,64,256] [--blocks=64,256,1024]\n"
+                     "          [--rates=44100,48000,96000] [--engines=oscillators,fft]\n"
+                     "          [--seconds=1] [--processor] [--format=csv|json] [--output=file]\n";
+        return 0;
+    }
+
+    auto voiceCounts = getList(args, "--voices", { 1, 8, 32, 128 });
+    auto harmonicCounts = getList(args, "--harmonics", { 16, 64, 256 });
+    auto blockSizes = getList(args, "--blocks", { 64, 256, 1024 });
+    auto sampleRates = getList(args, "--rates", { 44100, 48000, 96000 });
+    double seconds = args.containsOption("--seconds") ? args.getValueForOption("--seconds").getDoubleValue() : 1.0;
+    bool json = args.getValueForOption("--format") == "json";
+
+    Array<Voice::Engine> engines;
+    StringArray engineNames = StringArray::fromTokens(args.containsOption("--engines") ? args.getValueForOption("--engines")
+                                                                                          : "oscillators", ",", "");
+    for (auto& name : engineNames)
+        engines.add(name == "fft" ? Voice::inverseFFTEngine : Voice::oscillatorEngine);
+
+    Array<BenchmarkResult> results;
+    for (auto engine : engines)
+        for (int voices : voiceCounts)
+            for (int harmonics : harmonicCounts)
+                for (int blockSize : blockSizes)
+                    for (int sampleRate : sampleRates)
+                    {
+                        harmonics = jmin(harmonics, AdditiveSynthPluginAudioProcessor::maxHarmonics);
+                        results.add(benchmarkVoices(engine, voices, harmonics, blockSize, sampleRate, seconds));
+
+                        if (args.containsOption("--processor"))
+                            results.add(benchmarkProcessor(engine, voices, harmonics, blockSize, sampleRate, seconds));
+
+                        // progress on stderr, so stdout stays a clean report
+                        std::cerr << "." << std::flush;
+                    }
+    std::cerr << std::endl;
+
+    String report = json ? toJSON(results) : toCSV(results);
+
+    if (args.containsOption("--output"))
+    {
+        File file = args.getFileForOption("--output");
+        if (!file.replaceWithText(report))
+        {
+            std::cerr << "Could not write " << file.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout << report;
+    }
+
+    return 0;
+}
@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    LoadMeter.cpp
+    Created: 19 Oct 2026 5:48:03pm
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#include "LoadMeter.h"
+
+LoadMeter::LoadMeter()
+{
+    for (auto& count : histogram)
+        count.store(0, memory_order_relaxed);
+}
+
+LoadMeter::~LoadMeter()
+{
+}
+
+void LoadMeter::prepare(double sampleRate)
+{
+    this->sampleRate = sampleRate;
+    reset();
+}
+
+void LoadMeter::blockFinished(int64 startTicks, int numSamples, int numVoices, int numPartials)
+{
+    if (numSamples <= 0)
+        return;
+
+    double blockSeconds = numSamples / sampleRate;
+    float blockLoad = (float)((Time::getHighResolutionTicks() - startTicks) * secondsPerTick / blockSeconds);
+
+    if (resetRequested.exchange(false, memory_order_acquire))
+    {
+        for (auto& count : histogram)
+            count.store(0, memory_order_relaxed);
+        load.store(blockLoad, memory_order_relaxed);
+        peakLoad.store(0.f, memory_order_relaxed);
+    }
+
+    // smoothing that doesn't depend on the block size
+    float smoothing = (float)(1.0 - exp(-blockSeconds / 0.3));
+    float smoothed = load.load(memory_order_relaxed);
+    load.store(smoothed + smoothing * (blockLoad - smoothed), memory_order_relaxed);
+
+    float peak = peakLoad.load(memory_order_relaxed) * (float)exp(-blockSeconds);
+    peakLoad.store(jmax(peak, blockLoad), memory_order_relaxed);
+
+    this->numVoices.store(numVoices, memory_order_relaxed);
+    this->numPartials.store(numPartials, memory_order_relaxed);
+
+    auto& bin = histogram[jlimit(0, numBins - 1, (int)(blockLoad * (numBins - 1)))];
+    bin.store(bin.load(memory_order_relaxed) + 1, memory_order_relaxed);
+}
+
+void LoadMeter::getHistogram(uint32* counts)
+{
+    for (int i = 0; i < numBins; i++)
+        counts[i] = histogram[i].load(memory_order_relaxed);
+}
+
+void LoadMeter::reset()
+{
+    resetRequested.store(true, memory_order_release);
+}
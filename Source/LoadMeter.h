@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    LoadMeter.h
+    Created: 19 Oct 2026 5:48:03pm
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+using namespace std;
+
+// Measures how much of each block's time processBlock used. The audio thread
+// stamps the start and end of a block, everything else reads the results
+// from any thread without locks. Block loads go into a histogram in 10%
+// steps; the last bin counts blocks that missed their deadline.
+class LoadMeter {
+
+public:
+    LoadMeter();
+    ~LoadMeter();
+
+    static constexpr int numBins = 11;
+
+    void prepare(double sampleRate);
+
+    // Audio thread
+    int64 blockStarted() { return Time::getHighResolutionTicks(); }
+    void blockFinished(int64 startTicks, int numSamples, int numVoices, int numPartials);
+
+    // Any thread. Loads are block time / block duration, 1 is the deadline.
+    float getLoad() { return load.load(memory_order_relaxed); }             // smoothed over ~0.3 s
+    float getPeakLoad() { return peakLoad.load(memory_order_relaxed); }     // falls back over ~1 s
+    int getNumVoices() { return numVoices.load(memory_order_relaxed); }
+    int getNumPartials() { return numPartials.load(memory_order_relaxed); }
+    uint32 getNumOverruns() { return histogram[numBins - 1].load(memory_order_relaxed); }
+    void getHistogram(uint32* counts);      // numBins block counts
+    void reset();                           // cleared by the audio thread on its next block
+
+private:
+    double sampleRate = 44100.0;
+    double secondsPerTick = Time::highResolutionTicksToSeconds(1);
+
+    atomic<float> load { 0.f };
+    atomic<float> peakLoad { 0.f };
+    atomic<int> numVoices { 0 };
+    atomic<int> numPartials { 0 };
+
+    // Only the audio thread writes, so increments don't need read-modify-write
+    atomic<uint32> histogram[numBins];
+    atomic<bool> resetRequested { false };
+
+    JUCE_DECLARE_NON_COPYABLE(LoadMeter)
+};
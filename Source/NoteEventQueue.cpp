@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    NoteEventQueue.cpp
+    Created: 20 Oct 2026 2:14:38pm
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#include "NoteEventQueue.h"
+
+static_assert((NoteEventQueue::capacity & (NoteEventQueue::capacity - 1)) == 0, "capacity has to be a power of 2");
+
+NoteEventQueue::NoteEventQueue()
+{
+    for (uint32 i = 0; i < (uint32)capacity; i++)
+        cells[i].sequence.store(i, memory_order_relaxed);
+}
+
+NoteEventQueue::~NoteEventQueue()
+{
+}
+
+bool NoteEventQueue::push(const NoteEvent& event)
+{
+    // claim a cell by moving the write position past it, then fill it
+    uint32 position = writePosition.load(memory_order_relaxed);
+    Cell* cell;
+    for (;;)
+    {
+        cell = &cells[position & (capacity - 1)];
+        int32 difference = (int32)(cell->sequence.load(memory_order_acquire) - position);
+
+        if (difference == 0)
+        {
+            if (writePosition.compare_exchange_weak(position, position + 1, memory_order_relaxed))
+                break;
+        }
+        else if (difference < 0)
+        {
+            return false;       // the audio thread hasn't read this cell yet
+        }
+        else
+        {
+            position = writePosition.load(memory_order_relaxed);    // another thread took it
+        }
+    }
+
+    cell->event = event;
+    cell->sequence.store(position + 1, memory_order_release);
+    return true;
+}
+
+bool NoteEventQueue::pop(NoteEvent& event)
+{
+    Cell& cell = cells[readPosition & (capacity - 1)];
+    if ((int32)(cell.sequence.load(memory_order_acquire) - (readPosition + 1)) < 0)
+        return false;
+
+    event = cell.event;
+    cell.sequence.store(readPosition + capacity, memory_order_release);
+    readPosition++;
+    return true;
+}
+
+void NoteEventQueue::prepare(double sampleRate)
+{
+    this->sampleRate = sampleRate;
+}
+
+void NoteEventQueue::beginBlock(int numSamples)
+{
+    blockSize = numSamples;
+
+    // events left from earlier blocks move to the front
+    if (firstPending > 0)
+    {
+        for (int i = firstPending; i < numPending; i++)
+            pending[i - firstPending] = pending[i];
+        numPending -= firstPending;
+        firstPending = 0;
+    }
+
+    // Everything is taken, an event that is due could be behind ones for
+    // much later. When there are too many, the latest are dropped.
+    NoteEvent event;
+    while (pop(event))
+    {
+        if (numPending == capacity)
+        {
+            if (event.time >= pending[numPending - 1].time)
+                continue;
+            numPending--;
+        }
+        schedule(event);
+    }
+}
+
+void NoteEventQueue::schedule(const NoteEvent& event)
+{
+    // Scripts mostly push in time order, so this rarely moves anything.
+    // Events at the same time keep the order they were pushed in.
+    int i = numPending;
+    while (i > firstPending && pending[i - 1].time > event.time)
+    {
+        pending[i] = pending[i - 1];
+        i--;
+    }
+    pending[i] = event;
+    numPending++;
+}
+
+bool NoteEventQueue::getNextEvent(NoteEvent& event, int& samplePosition)
+{
+    if (firstPending == numPending)
+        return false;
+
+    const NoteEvent& next = pending[firstPending];
+    double position = (next.time - blockStartTime) * sampleRate;
+    if (position >= blockSize - 0.5)
+        return false;       // a later block
+
+    event = next;
+    samplePosition = position > 0.0 ? (int)std::lround(position) : 0;     // late events play right away
+    firstPending++;
+    return true;
+}
+
+void NoteEventQueue::endBlock()
+{
+    blockStartTime += blockSize / sampleRate;
+    time.store(blockStartTime, memory_order_relaxed);
+}
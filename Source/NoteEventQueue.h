@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    NoteEventQueue.h
+    Created: 20 Oct 2026 2:14:38pm
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+using namespace std;
+
+// Something Unity wants to happen at a given time
+struct NoteEvent
+{
+    enum Type
+    {
+        noteOn = 0,
+        noteOff,
+        parameterChange
+    };
+
+    double time;            // seconds on the queue's clock, see NoteEventQueue::getTime()
+    Type type;
+    int number;             // note (0 - 127) or parameter index
+    float value;            // frequency in Hz or normalised parameter value
+    float velocity;         // note on, 0 - 1
+};
+
+// Timestamped events from any number of threads to the audio thread. Pushing
+// never locks or allocates, so a game script can fire as many notes per frame
+// as fit. The audio thread takes the events that fall in each block in time
+// order, together with their sample position. Events for later blocks wait
+// in the queue, events from the past play at the start of the next block.
+// At most capacity events wait for later blocks. Past that the latest ones
+// are dropped, so events that are due never wait behind ones far ahead.
+class NoteEventQueue {
+
+public:
+    NoteEventQueue();
+    ~NoteEventQueue();
+
+    static constexpr int capacity = 1024;       // events waiting at most, power of 2
+
+    // Any thread. False when the queue is full and the event was dropped.
+    bool push(const NoteEvent& event);
+    double getTime() { return time.load(memory_order_relaxed); }    // start of the next block, seconds
+
+    // Audio thread. The clock keeps running over prepare(), so events that
+    // were scheduled before it still play at the time they asked for.
+    void prepare(double sampleRate);
+    void beginBlock(int numSamples);
+    bool getNextEvent(NoteEvent& event, int& samplePosition);      // in time order, false when done
+    void endBlock();
+
+private:
+    bool pop(NoteEvent& event);
+    void schedule(const NoteEvent& event);
+
+    // Bounded multi-producer queue: a cell can be written when its sequence
+    // equals the write position and read when it equals the read position + 1
+    struct Cell
+    {
+        atomic<uint32> sequence;
+        NoteEvent event;
+    };
+    Cell cells[capacity];
+    atomic<uint32> writePosition { 0 };
+    uint32 readPosition = 0;            // audio thread
+
+    // Audio thread: events taken from the queue, sorted by time, the earliest capacity of them
+    NoteEvent pending[capacity];
+    int firstPending = 0;
+    int numPending = 0;
+
+    double sampleRate = 44100.0;
+    double blockStartTime = 0.0;        // seconds, audio thread
+    int blockSize = 0;
+    atomic<double> time { 0.0 };        // blockStartTime for the other threads
+
+    JUCE_DECLARE_NON_COPYABLE(NoteEventQueue)
+};
@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    OscillatorArrays.h
+    Created: 26 Oct 2026 10:20:14am
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+
+// What the oscillator kernels work on, in plain C++. OscillatorBankAVX2.cpp
+// only includes this and OscillatorKernels.h: inline JUCE or standard
+// library functions compiled there could be emitted with AVX2 instructions
+// and picked by the linker for the whole binary, on CPUs without AVX2 too.
+
+// How an OscillatorBank computes its partials
+enum OscillatorMode
+{
+    sineMode = 0,       // phase accumulator and polynomial sine
+    rotatorMode,        // complex multiply per sample, no sine at all
+    fixedPointMode,     // uint32 phase and an interpolated sine table, bit exact everywhere
+    numOscillatorModes
+};
+
+namespace OscillatorKernels
+{
+    static constexpr int simdWidth = 8;         // padding, widest kernel (AVX2 float)
+
+    // Pointers to the aligned SoA arrays of a bank
+    template <typename SampleType>
+    struct Arrays
+    {
+        SampleType* gain;           // gain at the start of the block
+        SampleType* targetGain;     // gain at the end of the block
+        SampleType* phase;          // sine mode: phase in cycles, [-0.5, 0.5]
+        SampleType* increment;      // cycles per sample, at a pitch ratio of 1
+        SampleType* re;             // rotator mode: cos and sin of the phase
+        SampleType* im;
+        SampleType* cosIncrement;   // rotator mode: rotation per sample, at the current pitch ratio
+        SampleType* sinIncrement;
+        uint32_t* fixedPhase;       // fixed point mode: phase and increment in 2^-32 cycles
+        uint32_t* fixedIncrement;   // at a pitch ratio of 1
+    };
+
+    // Pitch ratio and gain ramps over one block
+    template <typename SampleType>
+    struct Ramp
+    {
+        const SampleType* ratio;    // per sample, exponential from ratioStart towards ratioEnd
+        SampleType ratioStart;
+        SampleType ratioEnd;        // at the end of this block
+        int gainLength;             // samples until the gains reach targetGain, at least the block
+    };
+
+    // Signature shared by all kernels
+    template <typename SampleType>
+    using Kernel = void (*)(const Arrays<SampleType>& arrays, const Ramp<SampleType>& ramp,
+                            int numPartials, SampleType* lanes, float* out, int numSamples);
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    // Compiled in OscillatorBankAVX2.cpp with AVX2 code generation enabled.
+    // The last argument only picks the sample type.
+    Kernel<float> getKernelAVX2(OscillatorMode mode, bool glide, float);
+    Kernel<double> getKernelAVX2(OscillatorMode mode, bool glide, double);
+#endif
+}
@@ -0,0 +1,577 @@
+/*
+  ==============================================================================
+
+    OscillatorBank.cpp
+    Created: 17 Oct 2026 10:02:41am
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#include "OscillatorBank.h"
+#include "OscillatorKernels.h"
+
+// The kernels that are the same on every CPU, never compiled for AVX2
+namespace OscillatorKernels
+{
+    template <typename SampleType>
+    struct ScalarOps
+    {
+        typedef SampleType V;
+        typedef SampleType Sample;
+        static constexpr int width = 1;
+
+        static V load(const Sample* p) { return *p; }
+        static void store(Sample* p, V v) { *p = v; }
+        static V set1(Sample v) { return v; }
+        static V add(V a, V b) { return a + b; }
+        static V sub(V a, V b) { return a - b; }
+        static V mul(V a, V b) { return a * b; }
+        static V min(V a, V b) { return a < b ? a : b; }
+        static V max(V a, V b) { return a > b ? a : b; }
+        static V round(V a) { return std::nearbyint(a); }
+        static Sample sum(V a) { return a; }
+    };
+
+    // One cycle of sine for the fixed point kernel, with the slope to the next
+    // entry stored next to each value: 2048 pairs, 16 KB. Built from a
+    // Taylor series in plain double arithmetic instead of std::sin, so the
+    // table is the same on every platform.
+    struct SineTable
+    {
+        static constexpr int bits = 11;
+        static constexpr int size = 1 << bits;
+
+        struct Entry
+        {
+            float value;
+            float slope;        // next value - value
+        };
+        Entry entries[size];
+
+        // sin(2 pi k / size) in double precision
+        static constexpr double sineOf(int k)
+        {
+            double x = (double)k / size;
+            x -= (int)(x + 0.5);                            // [-0.5, 0.5]
+            x = x > 0.25 ? 0.5 - x : x < -0.25 ? -0.5 - x : x;  // [-0.25, 0.25]
+
+            double y = 2.0 * 3.141592653589793 * x;
+            double term = y, sum = y;
+            for (int n = 1; n < 10; n++)           // up to y^19, below double rounding for |y| <= pi / 2
+            {
+                term *= -y * y / ((2 * n) * (2 * n + 1));
+                sum += term;
+            }
+            return sum;
+        }
+
+        static constexpr SineTable build()
+        {
+            SineTable table {};
+            double next = sineOf(0);
+            for (int k = 0; k < size; k++)
+            {
+                double value = next;
+                next = sineOf(k + 1);
+                table.entries[k] = { (float)value, (float)(next - value) };
+            }
+            return table;
+        }
+    };
+
+    const SineTable& getSineTable();        // shared by all banks, below
+
+    // Phases are uint32 fractions of a cycle, so they wrap on overflow with no
+    // branch and never lose precision, however long the note is. The top bits
+    // of the phase pick a table entry and the rest interpolate.
+    //
+    // This kernel is plain C++ on purpose, it is the same on every CPU and
+    // always sums in groups of simdWidth lanes in the same order, which
+    // makes its output bit exact across platforms. The partial loop is left
+    // to the compiler to vectorize. A glide moves the increment linearly in
+    // integer steps from ramp.ratioStart to ramp.ratioEnd.
+#if defined(__GNUC__) && ! defined(__clang__)
+    #pragma GCC push_options
+    #pragma GCC optimize ("fp-contract=off")   // a fused multiply-add would round differently
+#endif
+    template <typename SampleType, bool Glide>
+    void renderFixedPoint(const Arrays<SampleType>& arrays,
+                          const Ramp<SampleType>& ramp,
+                          int numPartials, SampleType* lanes, float* out, int numSamples)
+    {
+#if defined(__clang__)
+        #pragma clang fp contract(off)
+#endif
+        static_assert(simdWidth == 8, "the final sum below is written out for 8 lanes");
+        const int width = simdWidth;
+        const int fractionBits = 32 - SineTable::bits;
+        const uint32_t fractionMask = (1u << fractionBits) - 1;
+        const float fractionScale = 1.f / (float)(1u << fractionBits);      // exact, a power of two
+        const SineTable::Entry* table = getSineTable().entries;
+        const SampleType rampScale = (SampleType)1 / ramp.gainLength;
+
+        for (int n = 0; n < numSamples * width; n++)
+            lanes[n] = 0;
+
+        // increment at a pitch ratio, rounded the same way everywhere
+        auto scale = [](uint32_t increment, double ratio)
+        {
+            double scaled = (double)(int32_t)increment * ratio;
+            scaled = scaled < -2147483648.0 ? -2147483648.0 : scaled > 2147483647.0 ? 2147483647.0 : scaled;
+            return (uint32_t)(int32_t)std::llround(scaled);
+        };
+
+        for (int p = 0; p < numPartials; p += width)
+        {
+            uint32_t phase[width], increment[width], incrementStep[width];
+            SampleType gain[width], gainStep[width];
+
+            for (int j = 0; j < width; j++)
+            {
+                phase[j] = arrays.fixedPhase[p + j];
+                increment[j] = scale(arrays.fixedIncrement[p + j], ramp.ratioStart);
+                incrementStep[j] = Glide ? (uint32_t)(int32_t)(((int64_t)(int32_t)scale(arrays.fixedIncrement[p + j], ramp.ratioEnd)
+                                                              - (int32_t)increment[j]) / numSamples) : 0;
+                gain[j] = arrays.gain[p + j];
+                gainStep[j] = (arrays.targetGain[p + j] - gain[j]) * rampScale;
+            }
+
+            for (int n = 0; n < numSamples; n++)
+            {
+                // the lookups on their own, so the arithmetic below vectorizes
+                // even without gather instructions
+                float value[width], slope[width];
+                for (int j = 0; j < width; j++)
+                {
+                    const SineTable::Entry& entry = table[phase[j] >> fractionBits];
+                    value[j] = entry.value;
+                    slope[j] = entry.slope;
+                }
+
+                SampleType* lane = lanes + n * width;
+                for (int j = 0; j < width; j++)
+                {
+                    float fraction = (float)(int32_t)(phase[j] & fractionMask) * fractionScale;     // signed converts faster
+                    float sine = value[j] + fraction * slope[j];
+
+                    lane[j] += gain[j] * (SampleType)sine;
+                    gain[j] += gainStep[j];
+                    phase[j] += increment[j];       // wraps modulo 2^32
+                    if (Glide)
+                        increment[j] += incrementStep[j];
+                }
+            }
+
+            for (int j = 0; j < width; j++)
+            {
+                arrays.fixedPhase[p + j] = phase[j];
+                arrays.gain[p + j] = ramp.gainLength <= numSamples ? arrays.targetGain[p + j] : gain[j];
+            }
+        }
+
+        for (int n = 0; n < numSamples; n++)
+        {
+            const SampleType* l = lanes + n * width;
+            out[n] += (float)(((l[0] + l[1]) + (l[2] + l[3])) + ((l[4] + l[5]) + (l[6] + l[7])));
+        }
+    }
+#if defined(__GNUC__) && ! defined(__clang__)
+    #pragma GCC pop_options
+#endif
+}
+
+#if JUCE_INTEL
+#include <emmintrin.h>
+
+namespace OscillatorKernels
+{
+    struct SSE2Ops
+    {
+        typedef __m128 V;
+        typedef float Sample;
+        static constexpr int width = 4;
+
+        static V load(const float* p) { return _mm_load_ps(p); }
+        static void store(float* p, V v) { _mm_store_ps(p, v); }
+        static V set1(float v) { return _mm_set1_ps(v); }
+        static V add(V a, V b) { return _mm_add_ps(a, b); }
+        static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+        static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+        static V min(V a, V b) { return _mm_min_ps(a, b); }
+        static V max(V a, V b) { return _mm_max_ps(a, b); }
+        static V round(V a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }   // round to nearest
+        static float sum(V a)
+        {
+            V s = _mm_add_ps(a, _mm_movehl_ps(a, a));
+            s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+            return _mm_cvtss_f32(s);
+        }
+    };
+
+    struct SSE2DoubleOps
+    {
+        typedef __m128d V;
+        typedef double Sample;
+        static constexpr int width = 2;
+
+        static V load(const double* p) { return _mm_load_pd(p); }
+        static void store(double* p, V v) { _mm_store_pd(p, v); }
+        static V set1(double v) { return _mm_set1_pd(v); }
+        static V add(V a, V b) { return _mm_add_pd(a, b); }
+        static V sub(V a, V b) { return _mm_sub_pd(a, b); }
+        static V mul(V a, V b) { return _mm_mul_pd(a, b); }
+        static V min(V a, V b) { return _mm_min_pd(a, b); }
+        static V max(V a, V b) { return _mm_max_pd(a, b); }
+        static V round(V a) { return _mm_cvtepi32_pd(_mm_cvtpd_epi32(a)); }   // round to nearest, phases are small
+        static double sum(V a) { return _mm_cvtsd_f64(_mm_add_sd(a, _mm_unpackhi_pd(a, a))); }
+    };
+
+    template <typename SampleType> struct SSE2OpsFor { typedef SSE2Ops Ops; };
+    template <> struct SSE2OpsFor<double> { typedef SSE2DoubleOps Ops; };
+}
+#endif
+
+template <typename SampleType>
+OscillatorBank<SampleType>::OscillatorBank()
+{
+    selectKernel();
+}
+
+template <typename SampleType>
+void OscillatorBank<SampleType>::setup(int maxPartials, int maxBlockSize, VoiceArena* arena)
+{
+    // round up to whole SIMD groups, so kernels never need a remainder loop
+    capacity = ((maxPartials + simdWidth - 1) / simdWidth) * simdWidth;
+    this->maxBlockSize = jmax(maxBlockSize, 1);
+
+    int numValues = getNumValues(capacity, this->maxBlockSize);
+    if (arena != nullptr)
+    {
+        arenaMemory = arena->take<SampleType>(numValues);
+        storage.clear();
+    }
+    else
+    {
+        // extra simdWidth values leave room to align the start to 32 bytes
+        arenaMemory = nullptr;
+        storage.assign(numValues + simdWidth, 0);
+    }
+
+    numPartials = 0;
+    setNumPartials(maxPartials);
+    resetPhases();
+}
+
+template <typename SampleType>
+size_t OscillatorBank<SampleType>::getMemorySize(int maxPartials, int maxBlockSize)
+{
+    int capacity = ((maxPartials + simdWidth - 1) / simdWidth) * simdWidth;
+    return VoiceArena::roundUp(getNumValues(capacity, jmax(maxBlockSize, 1)) * sizeof(SampleType));
+}
+
+template <typename SampleType>
+int OscillatorBank<SampleType>::getNumValues(int capacity, int maxBlockSize)
+{
+    return 2 * numArrays * capacity + maxBlockSize * simdWidth + maxBlockSize;
+}
+
+template <typename SampleType>
+void OscillatorBank<SampleType>::setNumPartials(int numPartials)
+{
+    numPartials = jlimit(0, capacity, ((numPartials + simdWidth - 1) / simdWidth) * simdWidth);
+
+    // partials past the end stay silent so the padding can always be rendered
+    for (int i = numPartials; i < capacity; i++)
+    {
+        setPartial(i, 0, 0);
+    }
+    this->numPartials = numPartials;
+}
+
+template <typename SampleType>
+void OscillatorBank<SampleType>::setPartial(int index, SampleType gain, SampleType increment)
+{
+    setGain(index, gain);
+    setIncrement(index, increment);
+}
+
+template <typename SampleType>
+void OscillatorBank<SampleType>::setGain(int index, SampleType gain)
+{
+    getArray(targetGainArray)[index] = gain;
+}
+
+template <typename SampleType>
+void OscillatorBank<SampleType>::setIncrement(int index, SampleType increment)
+{
+    // keep the increment in [-0.5, 0.5] like the phase, partials above nyquist alias
+    increment = increment - std::nearbyint(increment);
+
+    getArray(incrementArray)[index] = increment;
+    getFixedArray(fixedIncrementArray)[index] = toFixedPoint(increment);
+    getArray(cosArray)[index] = (SampleType)cos(2.0 * double_Pi * increment * pitchRatio);
+    getArray(sinArray)[index] = (SampleType)sin(2.0 * double_Pi * increment * pitchRatio);
+}
+
+template <typename SampleType>
+void OscillatorBank<SampleType>::setPitchRatio(SampleType ratio)
+{
+    targetPitchRatio = ratio;
+}
+
+template <typename SampleType>
+void OscillatorBank<SampleType>::updateRotations()
+{
+    Arrays a = getArrays();
+    for (int i = 0; i < capacity; i++)
+    {
+        a.cosIncrement[i] = (SampleType)cos(2.0 * double_Pi * a.increment[i] * pitchRatio);
+        a.sinIncrement[i] = (SampleType)sin(2.0 * double_Pi * a.increment[i] * pitchRatio);
+    }
+}
+
+template <typename SampleType>
+void OscillatorBank<SampleType>::resetPhases()
+{
+    fill(getArray(phaseArray), getArray(phaseArray) + capacity, (SampleType)0);
+    fill(getArray(reArray), getArray(reArray) + capacity, (SampleType)1);
+    fill(getArray(imArray), getArray(imArray) + capacity, (SampleType)0);
+    fill(getFixedArray(fixedPhaseArray), getFixedArray(fixedPhaseArray) + capacity, 0u);
+}
+
+template <typename SampleType>
+double OscillatorBank<SampleType>::getPhase(int index)
+{
+    if (mode == rotatorMode)
+        return atan2(getArray(imArray)[index], getArray(reArray)[index]) / (2.0 * double_Pi);
+
+    if (mode == fixedPointMode)
+        return (int32)getFixedArray(fixedPhaseArray)[index] / 4294967296.0;
+
+    return getArray(phaseArray)[index];
+}
+
+template <typename SampleType>
+void OscillatorBank<SampleType>::setPhase(int index, double phase)
+{
+    phase -= nearbyint(phase);
+
+    getArray(phaseArray)[index] = (SampleType)phase;
+    getArray(reArray)[index] = (SampleType)cos(2.0 * double_Pi * phase);
+    getArray(imArray)[index] = (SampleType)sin(2.0 * double_Pi * phase);
+    getFixedArray(fixedPhaseArray)[index] = toFixedPoint(phase);
+}
+
+template <typename SampleType>
+SampleType OscillatorBank<SampleType>::getGain(int index)
+{
+    return getArray(gainArray)[index];
+}
+
+template <typename SampleType>
+void OscillatorBank<SampleType>::reorder(const int* previousIndex, int count)
+{
+    // copied as bytes, the fixed point arrays aren't SampleType values
+    SampleType* scratch = getReorderScratch();
+    memcpy(scratch, getMemory(), numArrays * capacity * sizeof(SampleType));
+
+    for (int a = 0; a < fixedPhaseArray; a++)
+    {
+        SampleType* array = getArray(a);
+        const SampleType* previous = scratch + a * capacity;
+        SampleType initial = (a == reArray || a == cosArray) ? 1 : 0;  // silent, phase 0
+
+        for (int i = 0; i < capacity; i++)
+        {
+            if (i < count && previousIndex[i] >= 0)
+                array[i] = previous[previousIndex[i]];
+            else
+                array[i] = initial;
+        }
+    }
+
+    for (int a = fixedPhaseArray; a < numArrays; a++)
+    {
+        uint32* array = getFixedArray(a);
+        const uint32* previous = reinterpret_cast<const uint32*>(scratch + a * capacity);
+
+        for (int i = 0; i < capacity; i++)
+            array[i] = (i < count && previousIndex[i] >= 0) ? previous[previousIndex[i]] : 0;
+    }
+}
+
+template <typename SampleType>
+void OscillatorBank<SampleType>::setMode(Mode newMode)
+{
+    if (newMode == mode)
+        return;
+
+    // carry the phase of every partial over to the new representation
+    for (int i = 0; i < capacity; i++)
+        setPhase(i, getPhase(i));
+
+    mode = newMode;
+    selectKernel();
+    updateRotations();
+}
+
+template <typename SampleType>
+void OscillatorBank<SampleType>::render(float* out, int numSamples)
+{
+    render(out, numSamples, numSamples, numSamples);
+}
+
+template <typename SampleType>
+void OscillatorBank<SampleType>::render(float* out, int numSamples, int gainRampSamples, int pitchRampSamples)
+{
+    SampleType* lanes = getLanes();
+    SampleType* ratioRamp = getRatioRamp();
+
+    int start = 0;
+    while (start < numSamples)
+    {
+        int chunkSize = jmin(numSamples - start, maxBlockSize);
+        int pitchLength = jmax(chunkSize, pitchRampSamples - start);
+
+        Ramp ramp = { ratioRamp, pitchRatio, targetPitchRatio, jmax(chunkSize, gainRampSamples - start) };
+        if (pitchRatio != targetPitchRatio)
+        {
+            // exponential glide, one multiply per sample
+            SampleType step = pow(targetPitchRatio / pitchRatio, (SampleType)1 / pitchLength);
+            SampleType ratio = pitchRatio;
+            for (int n = 0; n < chunkSize; n++)
+            {
+                ratioRamp[n] = ratio;
+                ratio *= step;
+            }
+
+            // a glide that goes on past this chunk stops where the chunk does
+            if (pitchLength > chunkSize)
+                ramp.ratioEnd = ratio;
+            glideKernel(getArrays(), ramp, numPartials, lanes, out + start, chunkSize);
+
+            pitchRatio = ramp.ratioEnd;
+            rotationsNeedUpdate = (mode == rotatorMode);
+        }
+        else
+        {
+            if (rotationsNeedUpdate)
+            {
+                updateRotations();
+                rotationsNeedUpdate = false;
+            }
+            kernel(getArrays(), ramp, numPartials, lanes, out + start, chunkSize);
+        }
+        start += chunkSize;
+    }
+}
+
+template <typename SampleType>
+double OscillatorBank<SampleType>::measureError(Mode mode, int numSamples)
+{
+    // the copy gets its own memory, so the test never touches this bank or an arena
+    OscillatorBank test = *this;
+    int numValues = getNumValues(capacity, maxBlockSize);
+    test.arenaMemory = nullptr;
+    test.storage.assign(numValues + simdWidth, 0);
+    copy(getMemory(), getMemory() + numValues, test.getMemory());
+    test.setMode(mode);
+
+    // measure at a steady gain and pitch
+    Arrays t = test.getArrays();
+    copy(t.targetGain, t.targetGain + capacity, t.gain);
+    test.pitchRatio = test.targetPitchRatio;
+    test.updateRotations();
+
+    // reference from the same starting phases, in double precision
+    Arrays a = test.getArrays();
+    vector<double> startPhase(numPartials);
+    for (int i = 0; i < numPartials; i++)
+    {
+        startPhase[i] = test.getPhase(i);
+    }
+
+    vector<float> rendered(numSamples, 0.f);
+    test.render(rendered.data(), numSamples);
+
+    double maxError = 0.0;
+    for (int n = 0; n < numSamples; n++)
+    {
+        double reference = 0.0;
+        for (int i = 0; i < numPartials; i++)
+        {
+            reference += a.gain[i] * sin(2.0 * double_Pi * (startPhase[i] + (double)a.increment[i] * test.pitchRatio * n));
+        }
+        maxError = jmax(maxError, abs(reference - (double)rendered[n]));
+    }
+    return maxError;
+}
+
+template <typename SampleType>
+typename OscillatorBank<SampleType>::Arrays OscillatorBank<SampleType>::getArrays()
+{
+    return { getArray(gainArray), getArray(targetGainArray), getArray(phaseArray), getArray(incrementArray),
+             getArray(reArray), getArray(imArray), getArray(cosArray), getArray(sinArray),
+             getFixedArray(fixedPhaseArray), getFixedArray(fixedIncrementArray) };
+}
+
+template <typename SampleType>
+SampleType* OscillatorBank<SampleType>::getMemory()
+{
+    if (arenaMemory != nullptr)
+        return arenaMemory;
+
+    // computed on every call instead of stored, so copying a bank stays safe
+    return reinterpret_cast<SampleType*>((reinterpret_cast<uintptr_t>(storage.data()) + 31) & ~(uintptr_t)31);
+}
+
+template <typename SampleType>
+SampleType* OscillatorBank<SampleType>::getArray(int index)
+{
+    return getMemory() + index * capacity;
+}
+
+template <typename SampleType>
+void OscillatorBank<SampleType>::selectKernel()
+{
+    typedef OscillatorKernels::ScalarOps<SampleType> ScalarOps;
+    kernel = OscillatorKernels::getKernel<ScalarOps>(mode, false);
+    glideKernel = OscillatorKernels::getKernel<ScalarOps>(mode, true);
+    kernelName = "scalar";
+
+#if JUCE_INTEL
+    typedef typename OscillatorKernels::SSE2OpsFor<SampleType>::Ops SSE2Ops;
+    if (SystemStats::hasSSE2())
+    {
+        kernel = OscillatorKernels::getKernel<SSE2Ops>(mode, false);
+        glideKernel = OscillatorKernels::getKernel<SSE2Ops>(mode, true);
+        kernelName = "SSE2";
+    }
+    if (SystemStats::hasAVX2())
+    {
+        kernel = OscillatorKernels::getKernelAVX2(mode, false, SampleType());
+        glideKernel = OscillatorKernels::getKernelAVX2(mode, true, SampleType());
+        kernelName = "AVX2";
+    }
+#endif
+
+    if (mode == fixedPointMode)
+    {
+        // one kernel for every CPU, that is what keeps it bit exact
+        kernel = OscillatorKernels::renderFixedPoint<SampleType, false>;
+        glideKernel = OscillatorKernels::renderFixedPoint<SampleType, true>;
+        kernelName = "fixed point";
+    }
+}
+
+// Filled in before any bank exists, the audio thread never builds it
+static const OscillatorKernels::SineTable sineTable = OscillatorKernels::SineTable::build();
+
+const OscillatorKernels::SineTable& OscillatorKernels::getSineTable()
+{
+    return sineTable;
+}
+
+template class OscillatorBank<float>;
+template class OscillatorBank<double>;
@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    OscillatorBank.h
+    Created: 17 Oct 2026 10:02:41am
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+#include "VoiceArena.h"
+#include "OscillatorArrays.h"
+using namespace std;
+
+// Bank of sine oscillators stored as structure-of-arrays. Gains, phases and
+// increments each live in their own aligned array, padded to the widest SIMD
+// width, so the partial loop processes 4 (SSE2) or 8 (AVX2) float partials
+// at once, or half as many doubles. The kernel is picked at runtime from what
+// the CPU supports. SampleType is float or double, the output is float.
+template <typename SampleType>
+class OscillatorBank {
+
+public:
+    OscillatorBank();
+
+    static constexpr int simdWidth = OscillatorKernels::simdWidth;     // padding, widest kernel (AVX2 float)
+
+    typedef OscillatorMode Mode;
+
+    // With an arena every array is taken from it, otherwise the bank
+    // allocates its own memory. getMemorySize() is what it takes.
+    void setup(int maxPartials, int maxBlockSize, VoiceArena* arena = nullptr);
+    static size_t getMemorySize(int maxPartials, int maxBlockSize);
+    void setNumPartials(int numPartials);
+    int getNumPartials() { return numPartials; }
+
+    void setMode(Mode newMode);
+    Mode getMode() { return mode; }
+
+    void setPartial(int index, SampleType gain, SampleType increment);   // increment in cycles per sample
+    void setGain(int index, SampleType gain);   // reached by ramping over the next block
+    void setIncrement(int index, SampleType increment);
+    void setPitchRatio(SampleType ratio);       // glides exponentially over the next block
+    void resetPhases();
+
+    SampleType getGain(int index);                      // gain reached so far, not the target
+    double getPhase(int index);                         // cycles
+    void setPhase(int index, double phase);
+
+    // Moves partial previousIndex[i] to slot i for i < count, so the bank can
+    // be kept compact. Slots with previousIndex -1 start silent at phase 0.
+    // Doesn't allocate.
+    void reorder(const int* previousIndex, int count);
+
+    void render(float* out, int numSamples);   // adds the sum of all partials to out
+    // The same, but the gains and the pitch ratio only reach their targets
+    // after that many samples, at least numSamples. A block that is split up
+    // keeps ramping over the whole of it.
+    void render(float* out, int numSamples, int gainRampSamples, int pitchRampSamples);
+
+    // Largest difference between this bank rendered in the given mode and a
+    // double precision std::sin reference, starting from the current state.
+    // Allocates, so only call it off the audio thread.
+    double measureError(Mode mode, int numSamples);
+
+    const char* getKernelName() { return kernelName; }
+
+    // Handed to the kernels, see OscillatorArrays.h
+    typedef OscillatorKernels::Arrays<SampleType> Arrays;
+    typedef OscillatorKernels::Ramp<SampleType> Ramp;
+    typedef OscillatorKernels::Kernel<SampleType> Kernel;
+
+private:
+    void selectKernel();
+    Arrays getArrays();
+    void updateRotations();         // exact cos and sin of every increment at the current ratio
+
+    static int getNumValues(int capacity, int maxBlockSize);
+    static uint32 toFixedPoint(double cycles) { return (uint32)(int64)std::llround(cycles * 4294967296.0); }
+
+    // Everything lives in one aligned block: the SoA arrays, a copy of them
+    // for reordering, per-sample lane sums and the pitch ratio of one block
+    SampleType* getMemory();
+    SampleType* getArray(int index);            // aligned start of one of the SoA arrays
+    SampleType* getReorderScratch() { return getMemory() + numArrays * capacity; }
+    SampleType* getLanes() { return getMemory() + 2 * numArrays * capacity; }
+    SampleType* getRatioRamp() { return getLanes() + maxBlockSize * simdWidth; }
+
+    SampleType* arenaMemory = nullptr;  // taken from a VoiceArena, copies of the bank share it
+    vector<SampleType> storage;         // own memory when there is no arena
+
+    int capacity = 0;               // partials per array, multiple of simdWidth
+    int numPartials = 0;            // partials in use, multiple of simdWidth
+    int maxBlockSize = 0;
+
+    SampleType pitchRatio = 1;
+    SampleType targetPitchRatio = 1;
+    bool rotationsNeedUpdate = false;   // set after a glide, which approximates the rotations
+
+    Mode mode = sineMode;
+    Kernel kernel = nullptr;        // constant pitch
+    Kernel glideKernel = nullptr;   // pitch ratio changes during the block
+    const char* kernelName = "";
+
+    // The fixed point arrays hold uint32 values in SampleType sized slots
+    enum { gainArray = 0, targetGainArray, phaseArray, incrementArray, reArray, imArray, cosArray, sinArray,
+           fixedPhaseArray, fixedIncrementArray, numArrays };
+    uint32_t* getFixedArray(int index) { return reinterpret_cast<uint32_t*>(getArray(index)); }
+};
@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    OscillatorBankAVX2.cpp
+    Created: 17 Oct 2026 10:31:56am
+    Author:  Helmer Nuijens
+
+    Built with the "avx2" compiler flag scheme (see the .jucer file). Only
+    called after SystemStats::hasAVX2() returned true. Includes no JUCE or
+    standard library headers, see OscillatorArrays.h.
+
+  ==============================================================================
+*/
+
+#include "OscillatorKernels.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)   // JUCE_INTEL
+#include <immintrin.h>
+
+namespace OscillatorKernels
+{
+    struct AVX2Ops
+    {
+        typedef __m256 V;
+        typedef float Sample;
+        static constexpr int width = 8;
+
+        static V load(const float* p) { return _mm256_load_ps(p); }
+        static void store(float* p, V v) { _mm256_store_ps(p, v); }
+        static V set1(float v) { return _mm256_set1_ps(v); }
+        static V add(V a, V b) { return _mm256_add_ps(a, b); }
+        static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+        static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+        static V min(V a, V b) { return _mm256_min_ps(a, b); }
+        static V max(V a, V b) { return _mm256_max_ps(a, b); }
+        static V round(V a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+        static float sum(V a)
+        {
+            __m128 s = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+            s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+            s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+            return _mm_cvtss_f32(s);
+        }
+    };
+
+    struct AVX2DoubleOps
+    {
+        typedef __m256d V;
+        typedef double Sample;
+        static constexpr int width = 4;
+
+        static V load(const double* p) { return _mm256_load_pd(p); }
+        static void store(double* p, V v) { _mm256_store_pd(p, v); }
+        static V set1(double v) { return _mm256_set1_pd(v); }
+        static V add(V a, V b) { return _mm256_add_pd(a, b); }
+        static V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+        static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+        static V min(V a, V b) { return _mm256_min_pd(a, b); }
+        static V max(V a, V b) { return _mm256_max_pd(a, b); }
+        static V round(V a) { return _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+        static double sum(V a)
+        {
+            __m128d s = _mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+            return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+        }
+    };
+
+    Kernel<float> getKernelAVX2(OscillatorMode mode, bool glide, float)
+    {
+        return getKernel<AVX2Ops>(mode, glide);
+    }
+
+    Kernel<double> getKernelAVX2(OscillatorMode mode, bool glide, double)
+    {
+        return getKernel<AVX2DoubleOps>(mode, glide);
+    }
+}
+#endif
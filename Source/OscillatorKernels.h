@@ -0,0 +1,190 @@
+/*
+  ==============================================================================
+
+    OscillatorKernels.h
+    Created: 17 Oct 2026 10:14:03am
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "OscillatorArrays.h"
+
+// Generic oscillator kernels. Each kernel is written once against an "Ops"
+// struct that wraps one instruction set (scalar, SSE2, AVX2). This header is
+// included by the translation units that instantiate the kernels, so the
+// AVX2 versions can be compiled with different code generation flags. It
+// includes nothing but OscillatorArrays.h, for the reason given there.
+// Ops::Sample is float or double, the kernels are the same for both.
+
+namespace OscillatorKernels
+{
+    // sin(2 pi x) for x in cycles, x in [-0.5, 0.5]. The input is folded to
+    // [-0.25, 0.25] and evaluated with a Taylor polynomial up to x^11 for
+    // float precision, or up to x^19 for double. It contains no branches.
+    template <typename Ops>
+    inline typename Ops::V sine(typename Ops::V x)
+    {
+        typedef typename Ops::V V;
+
+        const V half = Ops::set1(0.5);
+        x = Ops::min(x, Ops::sub(half, x));
+        x = Ops::max(x, Ops::sub(Ops::set1(-0.5), x));
+
+        const V x2 = Ops::mul(x, x);
+        V p;
+        if (sizeof(typename Ops::Sample) == sizeof(double))
+        {
+            p = Ops::set1(-0.012031585942120619);                              // -(2 pi)^19 / 19!
+            p = Ops::add(Ops::mul(p, x2), Ops::set1(0.10422916220813978));     //  (2 pi)^17 / 17!
+            p = Ops::add(Ops::mul(p, x2), Ops::set1(-0.7181223017785001));     // -(2 pi)^15 / 15!
+            p = Ops::add(Ops::mul(p, x2), Ops::set1(3.8199525848482803));      //  (2 pi)^13 / 13!
+            p = Ops::add(Ops::mul(p, x2), Ops::set1(-15.094642576822984));     // -(2 pi)^11 / 11!
+        }
+        else
+        {
+            p = Ops::set1(-15.094642576822984);             // -(2 pi)^11 / 11!
+        }
+        p = Ops::add(Ops::mul(p, x2), Ops::set1(42.058693944897634));  //  (2 pi)^9 / 9!
+        p = Ops::add(Ops::mul(p, x2), Ops::set1(-76.70585975306136));  // -(2 pi)^7 / 7!
+        p = Ops::add(Ops::mul(p, x2), Ops::set1(81.60524927607504));   //  (2 pi)^5 / 5!
+        p = Ops::add(Ops::mul(p, x2), Ops::set1(-41.341702240399755)); // -(2 pi)^3 / 3!
+        p = Ops::add(Ops::mul(p, x2), Ops::set1(6.283185307179586));   //   2 pi
+        return Ops::mul(p, x);
+    }
+
+    // Partial-major: a group of Ops::width partials stays in registers for the
+    // whole block and adds into a lane buffer, which is reduced once at the end.
+    // Gains ramp linearly to their targets over ramp.gainLength samples, the
+    // block is the first numSamples of those. When Glide is true
+    // the pitch ratio follows ramp.ratio sample by sample, otherwise it is
+    // constant. Both are decided per block, there are no per-sample branches.
+    template <typename Ops, bool Glide>
+    void renderSine(const Arrays<typename Ops::Sample>& arrays,
+                    const Ramp<typename Ops::Sample>& ramp,
+                    int numPartials, typename Ops::Sample* lanes, float* out, int numSamples)
+    {
+        typedef typename Ops::V V;
+        typedef typename Ops::Sample Sample;
+        const int width = Ops::width;
+        const V rampScale = Ops::set1((Sample)1 / ramp.gainLength);
+        const bool rampEnds = ramp.gainLength <= numSamples;
+
+        for (int n = 0; n < numSamples; n++)
+            Ops::store(lanes + n * width, Ops::set1(0));
+
+        for (int p = 0; p < numPartials; p += width)
+        {
+            V ph = Ops::load(arrays.phase + p);
+            const V inc = Ops::load(arrays.increment + p);
+            const V steadyInc = Ops::mul(inc, Ops::set1(ramp.ratioStart));
+            V g = Ops::load(arrays.gain + p);
+            const V target = Ops::load(arrays.targetGain + p);
+            const V step = Ops::mul(Ops::sub(target, g), rampScale);
+
+            for (int n = 0; n < numSamples; n++)
+            {
+                V acc = Ops::load(lanes + n * width);
+                Ops::store(lanes + n * width, Ops::add(acc, Ops::mul(g, sine<Ops>(ph))));
+                g = Ops::add(g, step);
+
+                ph = Ops::add(ph, Glide ? Ops::mul(inc, Ops::set1(ramp.ratio[n])) : steadyInc);
+                ph = Ops::sub(ph, Ops::round(ph));      // wrap to [-0.5, 0.5] without a branch
+            }
+            Ops::store(arrays.phase + p, ph);
+            Ops::store(arrays.gain + p, rampEnds ? target : g);
+        }
+
+        for (int n = 0; n < numSamples; n++)
+            out[n] += (float)Ops::sum(Ops::load(lanes + n * width));
+    }
+
+    // Each partial is a unit phasor (re, im) rotated by (cos, sin) of its
+    // increment every sample: four multiplies and two adds instead of a sine.
+    // Rounding slowly changes the length of the phasor, so it is pulled back
+    // to 1 at the end of every block with one Newton step of 1 / sqrt(r^2).
+    // When Glide is true the rotation itself is rotated a little every sample,
+    // which moves the pitch linearly from ramp.ratioStart to ramp.ratioEnd.
+    template <typename Ops, bool Glide>
+    void renderRotator(const Arrays<typename Ops::Sample>& arrays,
+                       const Ramp<typename Ops::Sample>& ramp,
+                       int numPartials, typename Ops::Sample* lanes, float* out, int numSamples)
+    {
+        typedef typename Ops::V V;
+        typedef typename Ops::Sample Sample;
+        const int width = Ops::width;
+        const V rampScale = Ops::set1((Sample)1 / ramp.gainLength);
+        const bool rampEnds = ramp.gainLength <= numSamples;
+        const V half = Ops::set1(0.5);
+        const V threeHalves = Ops::set1(1.5);
+
+        // angle added to the rotation per sample is 2 pi increment * this
+        const V glideScale = Ops::set1((Sample)(2.0 * 3.14159265358979 * (ramp.ratioEnd - ramp.ratioStart) / numSamples));
+
+        for (int n = 0; n < numSamples; n++)
+            Ops::store(lanes + n * width, Ops::set1(0));
+
+        for (int p = 0; p < numPartials; p += width)
+        {
+            V re = Ops::load(arrays.re + p);
+            V im = Ops::load(arrays.im + p);
+            V c = Ops::load(arrays.cosIncrement + p);
+            V s = Ops::load(arrays.sinIncrement + p);
+            V g = Ops::load(arrays.gain + p);
+            const V target = Ops::load(arrays.targetGain + p);
+            const V step = Ops::mul(Ops::sub(target, g), rampScale);
+
+            // small angle rotation per sample, the bank restores exact
+            // coefficients once the pitch stops moving
+            const V delta = Ops::mul(Ops::load(arrays.increment + p), glideScale);
+            const V deltaCos = Ops::sub(Ops::set1(1), Ops::mul(half, Ops::mul(delta, delta)));
+
+            for (int n = 0; n < numSamples; n++)
+            {
+                V acc = Ops::load(lanes + n * width);
+                Ops::store(lanes + n * width, Ops::add(acc, Ops::mul(g, im)));
+                g = Ops::add(g, step);
+
+                const V nextRe = Ops::sub(Ops::mul(re, c), Ops::mul(im, s));
+                im = Ops::add(Ops::mul(re, s), Ops::mul(im, c));
+                re = nextRe;
+
+                if (Glide)
+                {
+                    const V nextC = Ops::sub(Ops::mul(c, deltaCos), Ops::mul(s, delta));
+                    s = Ops::add(Ops::mul(c, delta), Ops::mul(s, deltaCos));
+                    c = nextC;
+                }
+            }
+
+            V k = Ops::sub(threeHalves, Ops::mul(half, Ops::add(Ops::mul(re, re), Ops::mul(im, im))));
+            Ops::store(arrays.re + p, Ops::mul(re, k));
+            Ops::store(arrays.im + p, Ops::mul(im, k));
+            Ops::store(arrays.gain + p, rampEnds ? target : g);
+
+            if (Glide)
+            {
+                k = Ops::sub(threeHalves, Ops::mul(half, Ops::add(Ops::mul(c, c), Ops::mul(s, s))));
+                Ops::store(arrays.cosIncrement + p, Ops::mul(c, k));
+                Ops::store(arrays.sinIncrement + p, Ops::mul(s, k));
+            }
+        }
+
+        for (int n = 0; n < numSamples; n++)
+            out[n] += (float)Ops::sum(Ops::load(lanes + n * width));
+    }
+
+    template <typename Ops>
+    Kernel<typename Ops::Sample> getKernel(OscillatorMode mode, bool glide)
+    {
+        switch (mode)
+        {
+        case rotatorMode:
+            return glide ? renderRotator<Ops, true> : renderRotator<Ops, false>;
+        default:
+            return glide ? renderSine<Ops, true> : renderSine<Ops, false>;
+        }
+    }
+}
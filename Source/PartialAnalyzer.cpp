@@ -0,0 +1,216 @@
+/*
+  ==============================================================================
+
+    PartialAnalyzer.cpp
+    Created: 24 Oct 2026 10:05:33am
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#include "PartialAnalyzer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+PartialAnalyzer::PartialAnalyzer(const Options& options)
+    : options(options),
+      fftSize(1 << options.fftOrder),
+      hopSize(jmax(1, (1 << options.fftOrder) / jmax(1, options.overlap))),
+      fft(options.fftOrder)
+{
+    this->options.maxPartials = jmax(1, options.maxPartials);
+
+    // periodic Hann window
+    window.resize(fftSize);
+    for (int n = 0; n < fftSize; n++)
+        window[n] = (float)(0.5 - 0.5 * cos(2.0 * double_Pi * n / fftSize));
+
+    buffer.resize(2 * fftSize);
+}
+
+PartialTracks PartialAnalyzer::analyze(const float* samples, int numSamples, double sampleRate)
+{
+    int numPartials = options.maxPartials;
+
+    // frame k is centred on sample k * hopSize, so it sounds at k / frameRate
+    int numFrames = jmax(0, numSamples - 1) / hopSize + 1;
+
+    vector<vector<Peak>> framePeaks(numFrames);
+    for (int k = 0; k < numFrames; k++)
+        findPeaks(samples, numSamples, k * hopSize - fftSize / 2, sampleRate, framePeaks[k]);
+
+    PartialTracks tracks;
+    tracks.frameRate = sampleRate / hopSize;
+    tracks.numPartials = numPartials;
+
+    // one frame more, in which the last tracks fade out
+    tracks.ratios.assign((size_t)(numFrames + 1) * numPartials, 0.f);
+    tracks.gains.assign((size_t)(numFrames + 1) * numPartials, 0.f);
+
+    slotFrequency.assign(numPartials, 0.f);
+    slotActive.assign(numPartials, 0);
+    slotClaimed.assign(numPartials, 0);
+
+    // the ratio rows hold frequencies in Hz until the fundamental is known
+    for (int k = 0; k < numFrames; k++)
+        track(framePeaks[k], k, tracks);
+    track({}, numFrames, tracks);
+
+    tracks.fundamental = options.fundamental > 0.0 ? options.fundamental : estimateFundamental(framePeaks);
+    for (float& ratio : tracks.ratios)
+        ratio = (float)(ratio / tracks.fundamental);
+
+    return tracks;
+}
+
+void PartialAnalyzer::findPeaks(const float* samples, int numSamples, int start, double sampleRate, vector<Peak>& peaks)
+{
+    // frames reaching past either end of the sound are padded with silence
+    for (int n = 0; n < fftSize; n++)
+    {
+        int index = start + n;
+        buffer[n] = index >= 0 && index < numSamples ? samples[index] * window[n] : 0.f;
+    }
+    fill(buffer.begin() + fftSize, buffer.end(), 0.f);
+
+    fft.performFrequencyOnlyForwardTransform(buffer.data());
+
+    // a full scale sine peaks at fftSize / 4 with a Hann window
+    const float scale = 4.f / fftSize;
+    const float threshold = pow(10.f, options.thresholdDb / 20.f) / scale;
+    const float tiny = 1.0e-20f;        // keeps log() finite
+
+    peaks.clear();
+    for (int b = 1; b < fftSize / 2; b++)
+    {
+        float magnitude = buffer[b];
+        if (magnitude < threshold || magnitude <= buffer[b - 1] || magnitude < buffer[b + 1])
+            continue;
+
+        // parabola through the log magnitudes of the peak and its neighbours
+        float left = log(buffer[b - 1] + tiny);
+        float centre = log(magnitude + tiny);
+        float right = log(buffer[b + 1] + tiny);
+        float curvature = left - 2.f * centre + right;
+        float offset = curvature < 0.f ? 0.5f * (left - right) / curvature : 0.f;
+
+        float frequency = (float)((b + offset) * sampleRate / fftSize);
+        if (frequency < options.minFrequency)
+            continue;
+
+        float gain = exp(centre - 0.25f * (left - right) * offset) * scale;
+        peaks.push_back({ frequency, gain });
+    }
+
+    // loudest first, and no more than could ever be matched or start a track
+    sort(peaks.begin(), peaks.end(), [](const Peak& a, const Peak& b) { return a.gain > b.gain; });
+    if ((int)peaks.size() > 2 * options.maxPartials)
+        peaks.resize(2 * options.maxPartials);
+}
+
+void PartialAnalyzer::track(const vector<Peak>& peaks, int frame, PartialTracks& tracks)
+{
+    int numPartials = tracks.numPartials;
+    float* frequencies = tracks.ratios.data() + (size_t)frame * numPartials;
+    float* gains = tracks.gains.data() + (size_t)frame * numPartials;
+
+    fill(slotClaimed.begin(), slotClaimed.end(), 0);
+    unmatched.clear();
+
+    // every peak continues the closest track that is still free
+    for (const Peak& peak : peaks)
+    {
+        int best = -1;
+        float bestDistance = FLT_MAX;
+        for (int s = 0; s < numPartials; s++)
+        {
+            if (!slotActive[s] || slotClaimed[s])
+                continue;
+
+            float distance = abs(peak.frequency - slotFrequency[s]);
+            if (distance <= options.maxDeviation * slotFrequency[s] && distance < bestDistance)
+            {
+                best = s;
+                bestDistance = distance;
+            }
+        }
+
+        if (best >= 0)
+        {
+            slotClaimed[best] = 1;
+            slotFrequency[best] = peak.frequency;
+            gains[best] = peak.gain;
+        }
+        else
+        {
+            unmatched.push_back(peak);
+        }
+    }
+
+    // Tracks without a peak die here: gain 0 at the frequency they had
+    for (int s = 0; s < numPartials; s++)
+        frequencies[s] = slotFrequency[s];
+
+    // New tracks take slots that were silent for the last two frames, so a
+    // track that just faded out isn't bent to the new frequency. The frame
+    // before the new one gets its frequency too, it fades in without a glide.
+    float* previousFrequencies = frame >= 1 ? frequencies - numPartials : nullptr;
+    const float* previousGains = frame >= 1 ? gains - numPartials : nullptr;
+    const float* olderGains = frame >= 2 ? gains - 2 * numPartials : nullptr;
+
+    int s = 0;
+    for (const Peak& peak : unmatched)
+    {
+        while (s < numPartials && (slotActive[s] || slotClaimed[s]
+                                   || (previousGains != nullptr && previousGains[s] != 0.f)
+                                   || (olderGains != nullptr && olderGains[s] != 0.f)))
+            s++;
+        if (s == numPartials)
+            break;                      // full, the quieter peaks are dropped
+
+        slotClaimed[s] = 1;
+        slotFrequency[s] = peak.frequency;
+        frequencies[s] = peak.frequency;
+        gains[s] = peak.gain;
+        if (previousFrequencies != nullptr)
+            previousFrequencies[s] = peak.frequency;
+    }
+
+    for (int i = 0; i < numPartials; i++)
+        slotActive[i] = slotClaimed[i];
+}
+
+double PartialAnalyzer::estimateFundamental(const vector<vector<Peak>>& framePeaks)
+{
+    // the loudest frame, where the partials are clearest
+    const vector<Peak>* loudest = nullptr;
+    float loudestTotal = 0.f;
+    for (const vector<Peak>& peaks : framePeaks)
+    {
+        float total = 0.f;
+        for (const Peak& peak : peaks)
+            total += peak.gain;
+
+        if (total > loudestTotal)
+        {
+            loudest = &peaks;
+            loudestTotal = total;
+        }
+    }
+
+    if (loudest == nullptr)
+        return 1.0;                     // silence, the ratios stay in Hz
+
+    // the lowest peak within 30 dB of the strongest, the fundamental of a
+    // harmonic sound can be weaker than its overtones
+    float minimum = loudest->front().gain * pow(10.f, -30.f / 20.f);
+    float fundamental = FLT_MAX;
+    for (const Peak& peak : *loudest)
+    {
+        if (peak.gain >= minimum)
+            fundamental = jmin(fundamental, peak.frequency);
+    }
+
+    return fundamental;
+}
@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    PartialAnalyzer.h
+    Created: 24 Oct 2026 10:05:33am
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+#include "PartialTrackFile.h"
+using namespace std;
+
+// Offline analysis of a recorded sound into partial tracks (McAulay &
+// Quatieri). A Hann windowed STFT finds the spectral peaks of every frame,
+// with frequency and amplitude refined by a parabola through the log
+// magnitudes around each peak. Peaks are then matched to the tracks of the
+// previous frame, loudest first, to the nearest track within maxDeviation.
+// Unmatched tracks die with a frame at gain 0, unmatched peaks start a track
+// in a free slot, fading in from gain 0 at their own frequency. Not real-time
+// safe, it allocates.
+class PartialAnalyzer {
+
+public:
+    struct Options
+    {
+        int fftOrder = 12;              // 4096 point frames
+        int overlap = 4;                // frames per window length
+        int maxPartials = 256;          // tracks sounding at once
+        float thresholdDb = -80.f;      // quieter peaks are ignored, dB below a full scale sine
+        float maxDeviation = 0.03f;     // frequency change a track follows from one frame to the next, relative
+        double minFrequency = 20.0;     // Hz
+        double fundamental = 0.0;       // Hz, 0 estimates it from the loudest frame
+    };
+
+    PartialAnalyzer(const Options& options);
+
+    PartialTracks analyze(const float* samples, int numSamples, double sampleRate);
+
+private:
+    struct Peak
+    {
+        float frequency;                // Hz
+        float gain;                     // amplitude of the sinusoid
+    };
+
+    void findPeaks(const float* samples, int numSamples, int start, double sampleRate, vector<Peak>& peaks);
+    void track(const vector<Peak>& peaks, int frame, PartialTracks& tracks);
+    double estimateFundamental(const vector<vector<Peak>>& framePeaks);
+
+    Options options;
+    int fftSize;
+    int hopSize;
+    dsp::FFT fft;
+    vector<float> window;
+    vector<float> buffer;               // 2 * fftSize, what the FFT works on
+
+    // one entry per slot while tracking
+    vector<float> slotFrequency;        // Hz, of the last peak
+    vector<char> slotActive;            // matched in the previous frame
+    vector<char> slotClaimed;           // matched in this frame
+    vector<Peak> unmatched;
+};
@@ -0,0 +1,180 @@
+/*
+  ==============================================================================
+
+    PartialEnvelopes.cpp
+    Created: 21 Oct 2026 10:41:17am
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#include "PartialEnvelopes.h"
+#include <climits>
+
+PartialEnvelopes::PartialEnvelopes(int numHarmonics, int numPoints, int sustainPoint)
+    : numHarmonics(jmax(numHarmonics, 0)),
+      numPoints(jlimit(0, (int)maxPoints, numPoints)),
+      sustainPoint(sustainPoint < this->numPoints ? sustainPoint : -1)
+{
+    times.assign(this->numPoints * this->numHarmonics, 0.f);
+    levels.assign(this->numPoints * this->numHarmonics, 1.f);
+}
+
+void PartialEnvelopes::setPoint(int harmonic, int point, float time, float level)
+{
+    jassert(harmonic >= 0 && harmonic < numHarmonics && point >= 0 && point < numPoints);
+
+    times[point * numHarmonics + harmonic] = jmax(time, 0.f);
+    levels[point * numHarmonics + harmonic] = level;
+}
+
+PartialEnvelopes PartialEnvelopes::createPluck(int numHarmonics, float attackTime, float decayTime, float brightness)
+{
+    // The decay halves the level every step, close enough to exponential,
+    // and the last step goes to 0
+    static constexpr int numDecaySteps = 5;
+    PartialEnvelopes envelopes(numHarmonics, 1 + numDecaySteps);
+
+    for (int h = 0; h < numHarmonics; h++)
+    {
+        float step = decayTime / (1.f + brightness * h) / numDecaySteps;
+
+        envelopes.setPoint(h, 0, attackTime, 1.f);
+        for (int p = 1; p <= numDecaySteps; p++)
+            envelopes.setPoint(h, p, step, p < numDecaySteps ? 1.f / (float)(1 << p) : 0.f);
+    }
+
+    return envelopes;
+}
+
+//==============================================================================
+void PartialEnvelopeState::setup(int maxHarmonics, VoiceArena* arena)
+{
+    this->maxHarmonics = maxHarmonics;
+
+    if (arena != nullptr)
+    {
+        ownMemory.clear();
+        level = arena->take<float>(maxHarmonics);
+        rate = arena->take<float>(maxHarmonics);
+        samplesLeft = arena->take<int>(maxHarmonics);
+        point = arena->take<int>(maxHarmonics);
+    }
+    else
+    {
+        // the int arrays live in float sized slots
+        ownMemory.assign(4 * maxHarmonics, 0.f);
+        level = ownMemory.data();
+        rate = level + maxHarmonics;
+        samplesLeft = reinterpret_cast<int*>(rate + maxHarmonics);
+        point = reinterpret_cast<int*>(rate + 2 * maxHarmonics);
+    }
+
+    // until the first note every partial holds at full level
+    for (int h = 0; h < maxHarmonics; h++)
+    {
+        level[h] = 1.f;
+        rate[h] = 0.f;
+        samplesLeft[h] = INT_MAX;
+        point[h] = PartialEnvelopes::maxPoints;
+    }
+    keyDown = false;
+}
+
+size_t PartialEnvelopeState::getMemorySize(int maxHarmonics)
+{
+    return 2 * VoiceArena::roundUp(maxHarmonics * sizeof(float))
+         + 2 * VoiceArena::roundUp(maxHarmonics * sizeof(int));
+}
+
+void PartialEnvelopeState::noteOn(const PartialEnvelopes& envelopes, double sampleRate)
+{
+    keyDown = true;
+
+    int count = jmin(maxHarmonics, envelopes.getNumHarmonics());
+    for (int h = 0; h < count; h++)
+        startSegment(envelopes, sampleRate, h, 0);
+
+    // harmonics past the table aren't shaped
+    for (int h = count; h < maxHarmonics; h++)
+    {
+        level[h] = 1.f;
+        rate[h] = 0.f;
+        samplesLeft[h] = INT_MAX;
+        point[h] = envelopes.getNumPoints();
+    }
+}
+
+void PartialEnvelopeState::noteOff(const PartialEnvelopes& envelopes, double sampleRate)
+{
+    keyDown = false;
+
+    // partials that haven't passed the sustain point yet release from where they are
+    int sustainPoint = envelopes.getSustainPoint();
+    if (sustainPoint < 0)
+        return;
+
+    int count = jmin(maxHarmonics, envelopes.getNumHarmonics());
+    for (int h = 0; h < count; h++)
+    {
+        if (point[h] <= sustainPoint)
+            startSegment(envelopes, sampleRate, h, sustainPoint + 1);
+    }
+}
+
+void PartialEnvelopeState::advance(const PartialEnvelopes& envelopes, double sampleRate, int numHarmonics, int numSamples)
+{
+    int count = jmin(numHarmonics, maxHarmonics, envelopes.getNumHarmonics());
+
+    // All partials at once, no branches, so this vectorizes
+    for (int h = 0; h < count; h++)
+    {
+        int step = jmin(numSamples, samplesLeft[h]);
+        level[h] += rate[h] * (float)step;
+        samplesLeft[h] -= step;
+    }
+
+    // Partials that reached a breakpoint go on from the next block
+    int sustainPoint = envelopes.getSustainPoint();
+    for (int h = 0; h < count; h++)
+    {
+        if (samplesLeft[h] > 0)
+            continue;
+
+        int p = point[h];
+        if (p >= envelopes.getNumPoints())
+        {
+            samplesLeft[h] = INT_MAX;       // done, keeps holding
+            continue;
+        }
+
+        level[h] = envelopes.getLevels(p)[h];   // exactly, whatever the rounding on the way
+        if (p == sustainPoint && keyDown)
+        {
+            rate[h] = 0.f;
+            samplesLeft[h] = INT_MAX;       // held until note off
+        }
+        else
+        {
+            startSegment(envelopes, sampleRate, h, p + 1);
+        }
+    }
+}
+
+void PartialEnvelopeState::startSegment(const PartialEnvelopes& envelopes, double sampleRate, int harmonic, int point)
+{
+    this->point[harmonic] = point;
+
+    if (point >= envelopes.getNumPoints())
+    {
+        rate[harmonic] = 0.f;
+        samplesLeft[harmonic] = INT_MAX;
+        return;
+    }
+
+    // clamped before rounding, lround() of a huge time doesn't fit an int
+    double length = jlimit(1.0, (double)INT_MAX, envelopes.getTimes(point)[harmonic] * sampleRate);
+    int numSamples = (int)std::lround(length);
+    rate[harmonic] = (envelopes.getLevels(point)[harmonic] - level[harmonic]) / (float)numSamples;
+    samplesLeft[harmonic] = numSamples;
+}
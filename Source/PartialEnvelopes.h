@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    PartialEnvelopes.h
+    Created: 21 Oct 2026 10:41:17am
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+#include "VoiceArena.h"
+using namespace std;
+
+// A breakpoint contour for every partial. Every breakpoint is stored as one
+// row of times and one row of levels over all harmonics, so a voice steps
+// all of its partials through the table with plain loops over contiguous
+// arrays. Times are seconds from the previous breakpoint, the first one from
+// note on. The levels multiply the spectrum's gains. With a sustain point,
+// partials hold there until note off and then go on with the next
+// breakpoints. After the last breakpoint they keep its level.
+class PartialEnvelopes {
+
+public:
+    PartialEnvelopes() {}                       // empty, the partials follow only the ADSR
+    PartialEnvelopes(int numHarmonics, int numPoints, int sustainPoint = -1);
+
+    static constexpr int maxPoints = 16;
+
+    void setPoint(int harmonic, int point, float time, float level);
+
+    bool isEmpty() const { return numPoints == 0; }
+    int getNumHarmonics() const { return numHarmonics; }
+    int getNumPoints() const { return numPoints; }
+    int getSustainPoint() const { return sustainPoint; }    // -1 when nothing is held
+
+    const float* getTimes(int point) const { return times.data() + point * numHarmonics; }
+    const float* getLevels(int point) const { return levels.data() + point * numHarmonics; }
+
+    // Struck string: a fast attack, then every partial falls to silence,
+    // higher ones sooner. brightness 0 decays all of them in decayTime,
+    // at 1 harmonic h takes decayTime / (1 + h).
+    static PartialEnvelopes createPluck(int numHarmonics, float attackTime, float decayTime, float brightness);
+
+private:
+    int numHarmonics = 0;
+    int numPoints = 0;
+    int sustainPoint = -1;
+    vector<float> times;            // numPoints rows of numHarmonics
+    vector<float> levels;
+};
+
+// Where every partial of one voice is in its envelope. SoA like the
+// oscillator bank, so advancing all partials by a block is one vectorizable
+// loop. Segments change at block boundaries: a breakpoint that falls inside
+// a block is reached at its end, and the oscillators ramp to it linearly.
+class PartialEnvelopeState {
+
+public:
+    void setup(int maxHarmonics, VoiceArena* arena = nullptr);
+    static size_t getMemorySize(int maxHarmonics);
+
+    // Every partial starts towards the first breakpoint from where it is now
+    void noteOn(const PartialEnvelopes& envelopes, double sampleRate);
+    void noteOff(const PartialEnvelopes& envelopes, double sampleRate);
+
+    // Levels at the end of the next numSamples, for the first numHarmonics
+    void advance(const PartialEnvelopes& envelopes, double sampleRate, int numHarmonics, int numSamples);
+    const float* getLevels() { return level; }
+
+private:
+    void startSegment(const PartialEnvelopes& envelopes, double sampleRate, int harmonic, int point);
+
+    float* level = nullptr;         // reached so far
+    float* rate = nullptr;          // change per sample in this segment
+    int* samplesLeft = nullptr;     // until the breakpoint
+    int* point = nullptr;           // breakpoint headed for, numPoints when done
+    vector<float> ownMemory;        // when there is no arena
+    int maxHarmonics = 0;
+    bool keyDown = false;
+};
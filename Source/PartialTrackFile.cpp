@@ -0,0 +1,127 @@
+/*
+  ==============================================================================
+
+    PartialTrackFile.cpp
+    Created: 24 Oct 2026 9:12:40am
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#include "PartialTrackFile.h"
+#include <cfloat>
+#include <climits>
+#include <cstring>
+
+#if JUCE_WINDOWS
+ #include <windows.h>
+#else
+ #include <sys/mman.h>
+#endif
+
+#if ! JUCE_LITTLE_ENDIAN
+ #error "track files are read in place, which needs a little-endian machine"
+#endif
+
+static const char trackFileMagic[4] = { 'A', 'P', 'T', 'F' };
+
+PartialTrackFile::PartialTrackFile(const File& file, unique_ptr<MemoryMappedFile> mapping, const Header& header)
+    : file(file),
+      mapping(std::move(mapping)),
+      numFrames((int)header.numFrames),
+      numPartials((int)header.numPartials),
+      frameRate(header.frameRate),
+      fundamental(header.fundamental)
+{
+    frames = reinterpret_cast<const float*>(static_cast<const char*>(this->mapping->getData()) + sizeof(Header));
+
+    // Checking the frames in open() paged them all in, locking keeps them
+    // there. When the system won't lock this much they stay mapped as they
+    // are and may be paged out again under memory pressure.
+   #if JUCE_WINDOWS
+    locked = VirtualLock(this->mapping->getData(), this->mapping->getSize()) != 0;
+   #else
+    locked = mlock(this->mapping->getData(), this->mapping->getSize()) == 0;
+   #endif
+}
+
+PartialTrackFile::~PartialTrackFile()
+{
+    if (!locked)
+        return;
+
+   #if JUCE_WINDOWS
+    VirtualUnlock(mapping->getData(), mapping->getSize());
+   #else
+    munlock(mapping->getData(), mapping->getSize());
+   #endif
+}
+
+PartialTrackFile::Ptr PartialTrackFile::open(const File& file)
+{
+    unique_ptr<MemoryMappedFile> mapping(new MemoryMappedFile(file, MemoryMappedFile::readOnly));
+    if (mapping->getData() == nullptr || mapping->getSize() < sizeof(Header))
+        return nullptr;
+
+    Header header;
+    memcpy(&header, mapping->getData(), sizeof(Header));
+
+    if (memcmp(header.magic, trackFileMagic, sizeof(trackFileMagic)) != 0 || header.version != version)
+        return nullptr;
+
+    if (header.numFrames == 0 || header.numPartials == 0 || header.numFrames > INT_MAX || header.numPartials > INT_MAX
+        || !(header.frameRate > 0.0 && header.frameRate <= DBL_MAX)
+        || !(header.fundamental > 0.0 && header.fundamental <= DBL_MAX))
+        return nullptr;
+
+    // a cut off file would have voices read past the mapping
+    uint64 frameSize = 2 * sizeof(float) * (uint64)header.numPartials;
+    if ((mapping->getSize() - sizeof(Header)) / frameSize < header.numFrames)
+        return nullptr;
+
+    // Voices use the frames as they are, so a NaN, infinite or negative
+    // ratio or gain would end up in the output. Both rows are checked alike.
+    const float* values = reinterpret_cast<const float*>(static_cast<const char*>(mapping->getData()) + sizeof(Header));
+    size_t numValues = 2 * (size_t)header.numPartials * header.numFrames;
+    for (size_t i = 0; i < numValues; i++)
+    {
+        if (!(values[i] >= 0.f && values[i] <= FLT_MAX))
+            return nullptr;
+    }
+
+    return new PartialTrackFile(file, std::move(mapping), header);
+}
+
+bool PartialTrackFile::write(const File& file, const PartialTracks& tracks)
+{
+    int numFrames = tracks.getNumFrames();
+    if (numFrames == 0 || tracks.ratios.size() != tracks.gains.size())
+        return false;
+
+    Header header;
+    memcpy(header.magic, trackFileMagic, sizeof(trackFileMagic));
+    header.version = version;
+    header.numFrames = (uint32)numFrames;
+    header.numPartials = (uint32)tracks.numPartials;
+    header.frameRate = tracks.frameRate;
+    header.fundamental = tracks.fundamental;
+
+    FileOutputStream out(file);
+    if (out.failedToOpen())
+        return false;
+
+    out.setPosition(0);
+    out.truncate();
+
+    bool written = out.write(&header, sizeof(Header));
+
+    size_t rowSize = tracks.numPartials * sizeof(float);
+    for (int frame = 0; frame < numFrames && written; frame++)
+    {
+        written = out.write(tracks.ratios.data() + (size_t)frame * tracks.numPartials, rowSize)
+               && out.write(tracks.gains.data() + (size_t)frame * tracks.numPartials, rowSize);
+    }
+
+    out.flush();
+    return written && out.getStatus().wasOk();
+}
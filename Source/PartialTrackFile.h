@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    PartialTrackFile.h
+    Created: 24 Oct 2026 9:12:40am
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <memory>
+#include <vector>
+using namespace std;
+
+// Time-varying partials of an analysed sound, as the analyzer makes them.
+// Every frame is one row of numPartials frequency ratios and one row of
+// gains. A partial keeps its slot from birth to death, between the two its
+// gain is 0.
+struct PartialTracks
+{
+    double frameRate = 0.0;         // frames per second
+    double fundamental = 0.0;       // Hz, the ratios are frequency / fundamental
+    int numPartials = 0;
+    vector<float> ratios;           // a row of numPartials per frame
+    vector<float> gains;            // amplitudes, a full scale sine is 1
+
+    int getNumFrames() const { return numPartials > 0 ? (int)(gains.size() / numPartials) : 0; }
+};
+
+// Partial tracks on disk, memory-mapped for playback. The file is a 32 byte
+// header followed by the frames, each a row of float ratios then a row of
+// float gains, little-endian:
+//
+//   char[4] "APTF", uint32 version, uint32 numFrames, uint32 numPartials,
+//   float64 frameRate, float64 fundamental
+//
+// Opening maps the file and checks the header and every frame: ratios and
+// gains have to be finite and not negative. The frames are then locked in
+// memory, so a voice reading them never waits for the disk. Voices read the
+// frames straight from the mapping, so a file is never parsed on the audio thread.
+// The mapping goes away with the last reference, keep that one on the
+// message thread (a Spectrum in the SpectrumPool does).
+class PartialTrackFile : public ReferenceCountedObject {
+
+public:
+    typedef ReferenceCountedObjectPtr<PartialTrackFile> Ptr;
+
+    ~PartialTrackFile();
+
+    static constexpr uint32 version = 1;
+
+    static Ptr open(const File& file);      // nullptr when it can't be mapped or isn't a valid track file
+    static bool write(const File& file, const PartialTracks& tracks);
+
+    int getNumFrames() const { return numFrames; }
+    int getNumPartials() const { return numPartials; }
+    double getFrameRate() const { return frameRate; }
+    double getFundamental() const { return fundamental; }
+    const File& getFile() const { return file; }
+
+    const float* getRatios(int frame) const { return frames + (size_t)frame * 2 * numPartials; }
+    const float* getGains(int frame) const { return getRatios(frame) + numPartials; }
+
+private:
+    struct Header
+    {
+        char magic[4];
+        uint32 version;
+        uint32 numFrames;
+        uint32 numPartials;
+        double frameRate;
+        double fundamental;
+    };
+    static_assert(sizeof(Header) == 32, "the header layout is the file format");
+
+    PartialTrackFile(const File& file, unique_ptr<MemoryMappedFile> mapping, const Header& header);
+
+    File file;
+    unique_ptr<MemoryMappedFile> mapping;
+    const float* frames = nullptr;
+    int numFrames = 0;
+    int numPartials = 0;
+    double frameRate = 0.0;
+    double fundamental = 0.0;
+    bool locked = false;            // the mapping is kept in memory
+
+    JUCE_DECLARE_NON_COPYABLE(PartialTrackFile)
+};
@@ -0,0 +1,151 @@
+/*
+  ==============================================================================
+
+    Patch.cpp
+    Created: 25 Oct 2026 9:47:02am
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#include "Patch.h"
+#include <cmath>
+
+static constexpr int patchMagic = 0x54505341;      // "ASPT" in the file
+
+// Checked before anything is allocated, a broken count can't ask for more
+// memory than the data it came with
+static bool hasBytes(InputStream& in, int64 numBytes)
+{
+    int64 remaining = in.getNumBytesRemaining();
+    return numBytes >= 0 && (remaining < 0 || remaining >= numBytes);
+}
+
+// A NaN or infinity would reach the voices and stay in their ramps and
+// envelopes, so a patch with one is rejected like a cut off one
+static bool readFloat(InputStream& in, float& value)
+{
+    value = in.readFloat();
+    return isfinite(value);
+}
+
+static bool readFloats(InputStream& in, int count, vector<double>& values)
+{
+    if (!hasBytes(in, (int64)count * 4))
+        return false;
+
+    values.resize(count);
+    for (int i = 0; i < count; i++)
+    {
+        float value;
+        if (!readFloat(in, value))
+            return false;
+        values[i] = value;
+    }
+    return true;
+}
+
+void Patch::writeToStream(OutputStream& out) const
+{
+    out.writeInt(patchMagic);
+    out.writeInt(version);
+
+    int count = jmin(numHarmonics, (int)gains.size());
+    out.writeInt(numHarmonics);
+    out.writeInt(count);
+    for (int h = 0; h < count; h++)
+        out.writeFloat((float)gains[h]);
+
+    int numRatios = jmin(numHarmonics, (int)ratios.size());
+    out.writeInt(numRatios);
+    for (int h = 0; h < numRatios; h++)
+        out.writeFloat((float)ratios[h]);
+
+    out.writeInt(envelopes.getNumHarmonics());
+    out.writeInt(envelopes.getNumPoints());
+    out.writeInt(envelopes.getSustainPoint());
+    for (int p = 0; p < envelopes.getNumPoints(); p++)
+    {
+        for (int h = 0; h < envelopes.getNumHarmonics(); h++)
+            out.writeFloat(envelopes.getTimes(p)[h]);
+        for (int h = 0; h < envelopes.getNumHarmonics(); h++)
+            out.writeFloat(envelopes.getLevels(p)[h]);
+    }
+
+    out.writeString(trackFile);
+    out.writeInt(preset);
+
+    out.writeFloat(adsr.attack);
+    out.writeFloat(adsr.decay);
+    out.writeFloat(adsr.sustain);
+    out.writeFloat(adsr.release);
+    out.writeInt(oscillatorMode);
+    out.writeInt(engine);
+    out.writeInt(numVoices);
+    out.writeInt(morphPreset);
+    out.writeFloat(morphAmount);
+    out.writeFloat(volume);
+    out.writeFloat(cent);
+}
+
+bool Patch::readFromStream(InputStream& in)
+{
+    if (!hasBytes(in, 8) || in.readInt() != patchMagic || in.readInt() < 1)
+        return false;
+
+    numHarmonics = in.readInt();
+    int count = in.readInt();
+    if (numHarmonics < 1 || count < 0 || count > numHarmonics || !readFloats(in, count, gains))
+        return false;
+
+    int numRatios = in.readInt();
+    if (numRatios < 0 || numRatios > numHarmonics || !readFloats(in, numRatios, ratios))
+        return false;
+
+    int numEnvelopeHarmonics = in.readInt();
+    int numPoints = in.readInt();
+    int sustainPoint = in.readInt();
+    if (numEnvelopeHarmonics < 0 || numPoints < 0 || numPoints > PartialEnvelopes::maxPoints
+        || !hasBytes(in, (int64)numPoints * numEnvelopeHarmonics * 8))
+        return false;
+
+    envelopes = PartialEnvelopes();
+    if (numPoints > 0 && numEnvelopeHarmonics > 0)
+    {
+        envelopes = PartialEnvelopes(numEnvelopeHarmonics, numPoints, sustainPoint);
+        vector<float> times(numEnvelopeHarmonics);
+        for (int p = 0; p < numPoints; p++)
+        {
+            // a row of times, then a row of levels
+            for (int h = 0; h < numEnvelopeHarmonics; h++)
+                if (!readFloat(in, times[h]))
+                    return false;
+            for (int h = 0; h < numEnvelopeHarmonics; h++)
+            {
+                float level;
+                if (!readFloat(in, level))
+                    return false;
+                envelopes.setPoint(h, p, times[h], level);
+            }
+        }
+    }
+
+    trackFile = in.readString();
+    preset = in.readInt();
+
+    if (!hasBytes(in, 11 * 4))
+        return false;
+
+    if (!readFloat(in, adsr.attack) || !readFloat(in, adsr.decay)
+        || !readFloat(in, adsr.sustain) || !readFloat(in, adsr.release))
+        return false;
+    oscillatorMode = in.readInt();
+    engine = in.readInt();
+    numVoices = in.readInt();
+    morphPreset = in.readInt();
+    if (!readFloat(in, morphAmount) || !readFloat(in, volume) || !readFloat(in, cent))
+        return false;
+
+    // fields of later versions would follow here
+    return true;
+}
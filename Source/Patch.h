@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    Patch.h
+    Created: 25 Oct 2026 9:47:02am
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+#include "PartialEnvelopes.h"
+using namespace std;
+
+// Everything that makes a sound: the spectrum, its partial envelopes and how
+// the voices play it. What getStateInformation() saves and what a
+// PresetBank holds, one per preset.
+//
+// Stored as little-endian binary: a magic number, a version, then the fields
+// in the order below, gains and ratios as floats and only as many as there
+// are harmonics. Later versions only append fields, so a patch from a newer
+// build still loads, without what this one doesn't know.
+struct Patch
+{
+    static constexpr int version = 1;
+
+    vector<double> gains;               // numHarmonics of them
+    vector<double> ratios;              // frequency / f0, empty when every partial is harmonic
+    PartialEnvelopes envelopes;
+    String trackFile;                   // partial tracks played instead of the gains, empty for none
+    int numHarmonics = 16;
+    int preset = 0;                     // PresetSpectra shape + 1 the gains come from, 0 for gains of its own
+    ADSR::Parameters adsr { 0.5f, 0.5f, 1.0f, 0.5f };
+    int oscillatorMode = 0;             // OscillatorMode
+    int engine = 0;                     // Voice::Engine
+    int numVoices = 64;
+    int morphPreset = -1;               // PresetSpectra shape, -1 for none
+    float morphAmount = 0.f;
+    float volume = 0.5f;
+    float cent = 0.f;                   // modulation
+
+    void writeToStream(OutputStream& out) const;
+    bool readFromStream(InputStream& in);  // false when it isn't a patch, is cut off or has a NaN or infinity
+};
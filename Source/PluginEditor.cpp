@@ -13,32 +13,12 @@
 AdditiveSynthPluginAudioProcessorEditor::AdditiveSynthPluginAudioProcessorEditor(AdditiveSynthPluginAudioProcessor& p)
     : AudioProcessorEditor(&p), audioProcessor(p)
 {
-    for (int h = 0; h < audioProcessor.numHarmonics; h++)
-    {
-        gainSliders.add(new Slider());
-        harmonicLabels.add(new Label());
-    }
-
     for (int i = 0; i < 4; i++)
     {
         ADSRSliders.add(new Slider());
     }
 
-    for (int h = 0; h < audioProcessor.numHarmonics; h++)
-    {
-        gainSliders[h]->addListener(this);
-        gainSliders[h]->setSliderStyle(Slider::SliderStyle::LinearBarVertical);
-        gainSliders[h]->setTextBoxStyle(Slider::TextBoxBelow, true, 50, 30);
-        gainSliders[h]->setRange(0.f, 1.f, 0.01f);
-        gainSliders[h]->setValue(audioProcessor.gainVector[h]);
-        //gainSliders[h]->setSliderSnapsToMousePosition(false);
-        addAndMakeVisible(gainSliders[h]);
-
-        harmonicLabels[h]->setText("f" + to_string(h), dontSendNotification);
-        harmonicLabels[h]->attachToComponent(gainSliders[h], false);
-        harmonicLabels[h]->setJustificationType(Justification::centred);
-        addAndMakeVisible(harmonicLabels[h]);
-    }
+    updateHarmonicSliders();
 
 
     for (int i = 0; i < 4; i++)
@@ -98,13 +78,17 @@ AdditiveSynthPluginAudioProcessorEditor::AdditiveSynthPluginAudioProcessorEditor
     modLabel.setJustificationType(Justification::centred);
     addAndMakeVisible(modLabel);
 
-
+    loadLabel.setJustificationType(Justification::centredLeft);
+    addAndMakeVisible(loadLabel);
+    audioProcessor.loadMeter.reset();
+    startTimerHz(10);
 
     setSize(600, 400);
 }
 
 AdditiveSynthPluginAudioProcessorEditor::~AdditiveSynthPluginAudioProcessorEditor()
 {
+    stopTimer();
 }
 
 //==============================================================================
@@ -119,13 +103,30 @@ void AdditiveSynthPluginAudioProcessorEditor::paint(juce::Graphics& g)
     auto area = getLocalBounds();
     auto labelHeight = 30;
     auto header = area.removeFromTop(getHeight() / 15);
+    histogramArea = header.removeFromRight(getWidth() / 3).reduced(2);
+    loadLabel.setBounds(header);
+
+    // Block loads in 10% steps, the red bin missed the deadline
+    uint32 mostBlocks = 1;
+    for (auto count : loadHistogram)
+        mostBlocks = jmax(mostBlocks, count);
+
+    auto bins = histogramArea;
+    float binWidth = histogramArea.getWidth() / (float)LoadMeter::numBins;
+    for (int i = 0; i < LoadMeter::numBins; i++)
+    {
+        auto bin = bins.removeFromLeft((int)binWidth).toFloat().reduced(1.f, 0.f);
+        g.setColour(i == LoadMeter::numBins - 1 ? Colours::red : Colours::white);
+        g.fillRect(bin.removeFromBottom(bin.getHeight() * loadHistogram[i] / (float)mostBlocks));
+    }
+    g.setColour(juce::Colours::white);
     //auto footer = area.removeFromBottom(header.getHeight());
     auto topArea = area.removeFromTop(3.f * getHeight() / 5.f);
     // g.drawRoundedRectangle(topArea.toFloat(), 10.f, 0.5f);
      //auto modArea = topArea.removeFromTop(getHeight() / 2.f);
     auto topLabelArea = topArea.removeFromBottom(labelHeight);
     auto gainSliderArea = topArea.removeFromRight(5.f * getWidth() / 6.f);
-    auto sliderArea = gainSliderArea.getWidth() / audioProcessor.numHarmonics;
+    auto sliderArea = gainSliderArea.getWidth() / jmax(1, gainSliders.size());
     // g.drawRoundedRectangle(area.toFloat(), 10.f, 0.5f);
     modSlider.setBounds(topArea);
 
@@ -138,7 +139,7 @@ void AdditiveSynthPluginAudioProcessorEditor::paint(juce::Graphics& g)
 
     auto ADSRSliderArea = area.getWidth() / 4.f;
 
-    for (int h = 0; h < audioProcessor.numHarmonics; h++)
+    for (int h = 0; h < gainSliders.size(); h++)
     {
         gainSliders[h]->setBounds(gainSliderArea.removeFromLeft(sliderArea));
     }
@@ -159,9 +160,58 @@ void AdditiveSynthPluginAudioProcessorEditor::resized()
     // subcomponents in your editor..
 }
 
+void AdditiveSynthPluginAudioProcessorEditor::timerCallback()
+{
+    LoadMeter& meter = audioProcessor.loadMeter;
+
+    loadLabel.setText("CPU " + String(roundToInt(meter.getLoad() * 100.f)) + "%"
+        + "  peak " + String(roundToInt(meter.getPeakLoad() * 100.f)) + "%"
+        + "  voices " + String(meter.getNumVoices())
+        + "  partials " + String(meter.getNumPartials())
+        + "  overruns " + String(meter.getNumOverruns()), dontSendNotification);
+
+    meter.getHistogram(loadHistogram);
+    repaint(histogramArea);
+
+    if (shownPatchChanges != audioProcessor.getPatchChanges() || gainSliders.size() != audioProcessor.numHarmonics)
+        updateHarmonicSliders();
+}
+
+void AdditiveSynthPluginAudioProcessorEditor::updateHarmonicSliders()
+{
+    int numHarmonics = audioProcessor.numHarmonics;
+    shownPatchChanges = audioProcessor.getPatchChanges();
+
+    // the labels are attached to the sliders, so they go first
+    harmonicLabels.removeRange(numHarmonics, harmonicLabels.size());
+    gainSliders.removeRange(numHarmonics, gainSliders.size());
+
+    for (int h = gainSliders.size(); h < numHarmonics; h++)
+    {
+        gainSliders.add(new Slider());
+        harmonicLabels.add(new Label());
+
+        gainSliders[h]->addListener(this);
+        gainSliders[h]->setSliderStyle(Slider::SliderStyle::LinearBarVertical);
+        gainSliders[h]->setTextBoxStyle(Slider::TextBoxBelow, true, 50, 30);
+        gainSliders[h]->setRange(0.f, 1.f, 0.01f);
+        //gainSliders[h]->setSliderSnapsToMousePosition(false);
+        addAndMakeVisible(gainSliders[h]);
+
+        harmonicLabels[h]->setText("f" + to_string(h), dontSendNotification);
+        harmonicLabels[h]->attachToComponent(gainSliders[h], false);
+        harmonicLabels[h]->setJustificationType(Justification::centred);
+        addAndMakeVisible(harmonicLabels[h]);
+    }
+
+    for (int h = 0; h < numHarmonics; h++)
+        gainSliders[h]->setValue(audioProcessor.gainVector[h], dontSendNotification);
+    repaint();
+}
+
 void AdditiveSynthPluginAudioProcessorEditor::sliderValueChanged(Slider* slider)
 {
-    for (int h = 0; h < audioProcessor.numHarmonics; h++)
+    for (int h = 0; h < gainSliders.size(); h++)
     {
         if (slider == gainSliders[h])
         {
@@ -17,7 +17,7 @@ using namespace std;
 /**
 */
 class AdditiveSynthPluginAudioProcessorEditor : public juce::AudioProcessorEditor,
-    public Slider::Listener
+    public Slider::Listener, private Timer
 {
 public:
     AdditiveSynthPluginAudioProcessorEditor(AdditiveSynthPluginAudioProcessor&);
@@ -28,8 +28,14 @@ public:
     void resized() override;
 
     void sliderValueChanged(Slider* slider) override;
+    void timerCallback() override;      // refreshes the load meter and the harmonic count
 
 private:
+    // One gain slider per harmonic. A loaded patch or preset can change the
+    // gains and the count, so they are made again after one.
+    void updateHarmonicSliders();
+    int shownPatchChanges = -1;     // the processor's count the sliders show
+
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
 
@@ -43,6 +49,10 @@ private:
     Label attackLabel, decayLabel, sustainLabel, releaseLabel;
     OwnedArray<Label> harmonicLabels;
 
+    Label loadLabel;
+    uint32 loadHistogram[LoadMeter::numBins] = {};
+    Rectangle<int> histogramArea;
+
     float attack = 0.5f;
     float decay = 0.5f;
     float sustain = 1.f;
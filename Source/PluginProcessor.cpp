@@ -8,6 +8,7 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "UnityBridge.h"
 
 
 
@@ -24,6 +25,18 @@ AdditiveSynthPluginAudioProcessor::AdditiveSynthPluginAudioProcessor()
     )
 #endif
 {
+    // everything is sized for the capacity once, changing counts later never allocates
+    synthVoices.resize(maxVoices);
+    sounding.assign(maxVoices, nullptr);
+    gainVector.assign(maxHarmonics, 0.0);
+    gainVector[0] = 1.f;
+    ratioVector.resize(maxHarmonics);
+    for (int h = 0; h < maxHarmonics; h++)
+        ratioVector[h] = h + 1.0;
+
+    // the presets are never released, so the audio thread can switch between them
+    for (int i = 0; i < PresetSpectra::numPresets; i++)
+        presetSpectra.add(new Spectrum(PresetSpectra::get(i).gains, maxHarmonics, PresetSpectra::get(i).ratios));
 
 #ifdef NOEDITOR
     addParameter(volume = new AudioParameterFloat("volume", // parameter ID
@@ -36,11 +49,6 @@ AdditiveSynthPluginAudioProcessor::AdditiveSynthPluginAudioProcessor()
         -24.0f,   // minimum value
         24.0f,   // maximum value
         0.0f)); // default value
-    addParameter(fundamentalFreq = new AudioParameterFloat("fundamentalFreq", // parameter ID
-        "FundamentalFreq", // parameter name
-        20.0f,   // minimum value
-        20000.0f,   // maximum value
-        440.0f)); // default value
     addParameter(attack = new AudioParameterFloat("attack", // parameter ID
         "Attack", // parameter name
         0.0f,   // minimum value
@@ -61,33 +69,64 @@ AdditiveSynthPluginAudioProcessor::AdditiveSynthPluginAudioProcessor()
         0.0f,   // minimum value
         25.0f,   // maximum value
         0.5f)); // default value
-    addParameter(voiceIsAdded = new AudioParameterBool("voiceIsAdded", // parameter ID
-        "Voice is Added", // parameter name
-        false   // default value
-        )); // default value
-    addParameter(resetVoices = new AudioParameterBool("resetVoices", // parameter ID
-        "Reset Voices", // parameter name
-        false   // default value
-    )); // default value
     addParameter(preset = new AudioParameterInt("preset", // parameter ID
         "Preset", // parameter name
         1,   // minimum value
-        4,   // maximum value
+        PresetSpectra::numPresets,   // maximum value, one per PresetSpectra::Shape
         1)); // default value
-    noteOnOff.reserve(numVoices); 
-    for (int h = 0; h < numVoices; h++)
-    {
-        noteOnOff.push_back(new AudioParameterBool("noteOnOff" + to_string(h), // parameter ID
-            "NoteOnOff" + to_string(h), // parameter name
-            false));
-
-        addParameter(noteOnOff[h]);
-    }
+    addParameter(morphPreset = new AudioParameterInt("morphPreset", // parameter ID
+        "Morph Preset", // parameter name
+        1,   // minimum value
+        PresetSpectra::numPresets,   // maximum value
+        1)); // default value
+    addParameter(morph = new AudioParameterFloat("morph", // parameter ID
+        "Morph", // parameter name
+        0.0f,   // minimum value, the preset
+        1.0f,   // maximum value, the morph preset
+        0.0f)); // default value
+    addParameter(oscillator = new AudioParameterChoice("oscillator", // parameter ID
+        "Oscillator", // parameter name
+        { "Sine", "Rotator", "Fixed Point" }, // one entry per OscillatorMode
+        0)); // default value
+    addParameter(engine = new AudioParameterChoice("engine", // parameter ID
+        "Engine", // parameter name
+        { "Oscillators", "Inverse FFT", "Wavetable" }, // one entry per Voice::Engine
+        0)); // default value
+    addParameter(parallel = new AudioParameterBool("parallel", // parameter ID
+        "Parallel Voices", // parameter name
+        true   // default value
+    )); // default value
+    addParameter(harmonics = new AudioParameterInt("harmonics", // parameter ID
+        "Harmonics", // parameter name
+        1,   // minimum value
+        maxHarmonics,   // maximum value
+        numHarmonics)); // default value
+
+    // Meters, written by processBlock. Setting them from Unity has no effect.
+    addParameter(cpuLoad = new AudioParameterFloat("cpuLoad", "CPU Load",
+        { 0.0f, 2.0f }, 0.0f, "", AudioProcessorParameter::outputMeter)); // fraction of the block duration
+    addParameter(peakLoad = new AudioParameterFloat("peakLoad", "Peak Load",
+        { 0.0f, 2.0f }, 0.0f, "", AudioProcessorParameter::outputMeter));
+    addParameter(activeVoicesMeter = new AudioParameterFloat("activeVoicesMeter", "Active Voices",
+        { 0.0f, (float)maxVoices }, 0.0f, "", AudioProcessorParameter::outputMeter));
+    addParameter(partialsMeter = new AudioParameterFloat("renderedPartials", "Rendered Partials",
+        { 0.0f, (float)(maxVoices * maxHarmonics) }, 0.0f, "", AudioProcessorParameter::outputMeter));
+    addParameter(overruns = new AudioParameterFloat("overruns", "Overruns",
+        { 0.0f, 1000000.0f }, 0.0f, "", AudioProcessorParameter::outputMeter)); // blocks that missed their deadline
+
+    // Unity plays notes through the queue, the script finds it by this id
+    instanceId = UnityBridge::addInstance(&noteEvents);
+    addParameter(instance = new AudioParameterFloat("instanceId", "Instance Id",
+        { 0.0f, (float)UnityBridge::maxInstances }, 0.0f, "", AudioProcessorParameter::outputMeter)); // 0 when all ids are taken
+    setMeter(instance, (float)instanceId);
 #endif
 }
 
 AdditiveSynthPluginAudioProcessor::~AdditiveSynthPluginAudioProcessor()
 {
+#ifdef NOEDITOR
+    UnityBridge::removeInstance(instanceId);
+#endif
 }
 
 //==============================================================================
@@ -130,21 +169,25 @@ double AdditiveSynthPluginAudioProcessor::getTailLengthSeconds() const
 
 int AdditiveSynthPluginAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    // The presets of the loaded bank. NB: some hosts don't cope very well if
+    // you tell them there are 0 programs, so this should be at least 1.
+    return presetBank != nullptr ? jmax(1, presetBank->size()) : 1;
 }
 
 int AdditiveSynthPluginAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram;
 }
 
 void AdditiveSynthPluginAudioProcessor::setCurrentProgram(int index)
 {
+    selectPreset(index);
 }
 
 const juce::String AdditiveSynthPluginAudioProcessor::getProgramName(int index)
 {
+    if (presetBank != nullptr && index >= 0 && index < presetBank->size())
+        return presetBank->getName(index);
     return {};
 }
 
@@ -157,31 +200,55 @@ void AdditiveSynthPluginAudioProcessor::prepareToPlay(double sampleRate, int sam
 {
     fs = sampleRate;
     nyquist = fs / 2.f;
-    gainVector.clear();
-    currentPlayingNotes.clear();
-    synthVoices.clear();
 
-    for (int h = 0; h < numHarmonics; h++)
+    // The vectors were sized for the capacity in the constructor, so this
+    // only resets them
+    fill(gainVector.begin(), gainVector.end(), 0.0);
+    gainVector[0] = 1.f;
+    for (int h = 0; h < maxHarmonics; h++)
+        ratioVector[h] = h + 1.0;
+    currentSpectrum = spectra.create(gainVector.data(), maxHarmonics, ratioVector.data(), partialEnvelopes);
+    audioSpectrum = currentSpectrum;
+
+    // One block for the per-sample data of every voice, only reallocated
+    // when the host asks for bigger blocks than before
+    arena.allocate(maxVoices * Voice::getMemorySize(maxHarmonics, samplesPerBlock));
+    audioNumHarmonics = numHarmonics;
+    audioADSR = { att, dec, sus, rel };
+    audioOscillatorMode = oscillatorMode;
+    audioEngine = synthEngine;
+    for (int i = 0; i < maxVoices; i++)
     {
-        gainVector.push_back(0.f);
+        synthVoices[i].setup(sampleRate, maxHarmonics, samplesPerBlock, &arena);
+        synthVoices[i].setNumHarmonics(audioNumHarmonics);
+        synthVoices[i].setSpectrum(nullptr);    // idle, gets audioSpectrum when it starts
+        synthVoices[i].setADSRParams(audioADSR);
+        synthVoices[i].setOscillatorMode((OscillatorMode)audioOscillatorMode);
+        synthVoices[i].setEngine((Voice::Engine)audioEngine);
     }
-    gainVector[0] = 1.f;
 
-    synthVoices.assign(numVoices, SynthVoice());
-    for (int i = 0; i < numVoices; i++)
-    {
+    voiceAllocator.prepare(synthVoices.data(), maxVoices);
+    voiceAllocator.setNumVoices(numVoices);
+
+    wavetables.prepare(sampleRate);
+    wavetables.requestBake(gainVector);
+    bakedNumHarmonics = maxHarmonics;
+
+    loadMeter.prepare(sampleRate);
+    appliedMorphAmount = -1.f;          // the voices were set up again, give them the morph on the next block
 #ifdef NOEDITOR
-        isPlaying.push_back(false);
+    noteEvents.prepare(sampleRate);
 #endif
-        currentPlayingNotes.push_back(0);
-        synthVoices[i].setup(sampleRate, numHarmonics);
-    }
+
+    // the workers are shared with the other instances
+    renderPool.prepare();
 }
 
 void AdditiveSynthPluginAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    renderPool.release();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -213,6 +280,10 @@ bool AdditiveSynthPluginAudioProcessor::isBusesLayoutSupported(const BusesLayout
 void AdditiveSynthPluginAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+    int64 blockStart = loadMeter.blockStarted();
+    blockVoices = 0;
+    blockPartials = 0;
+
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -220,130 +291,301 @@ void AdditiveSynthPluginAudioProcessor::processBlock(juce::AudioBuffer<float>& b
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
+    // Taken before the voice parameters, they then include the bank it belongs to
+    int presetIndex = pendingPreset.exchange(-1);
+
+    // Latest spectrum and envelope from the message thread, if they changed
+    if (auto* parameters = voiceParameters.read())
+        applyVoiceParameters(*parameters);
+
+    if (presetIndex >= 0)
+        applyPreset(presetIndex);
+
+    if (voiceAllocator.getNumVoices() != numVoices)
+    {
+        // voices past the new count are released and not started again
+        voiceAllocator.setNumVoices(numVoices);
+        for (int i = 0; i < voiceAllocator.getNumActive(); i++)
+        {
+            int voice = voiceAllocator.getActiveVoices()[i];
+            if (voice >= numVoices)
+            {
+                voiceAllocator.stopVoice(voice);
+                synthVoices[voice].noteOff();
+            }
+        }
+    }
+
+    voiceAllocator.setPolicy((VoiceAllocator::Policy)stealPolicy.load());
+
+#ifndef NOEDITOR 
+    // idle voices pick up the modulation when they start
+    for (int i = 0; i < voiceAllocator.getNumActive(); i++)
+    {
+        int voice = voiceAllocator.getActiveVoices()[i];
+        synthVoices[voice].cent = cent;
+        synthVoices[voice].setAngleChange();
+    }
+#else
+    updateParameters();
+#endif
+    applyMorph();
+    applyModeAndEngine();
+
+    auto outL = buffer.getWritePointer(0);
+    auto outR = buffer.getWritePointer(1);
+    int numSamples = buffer.getNumSamples();
+
+    // nullptr while the spectrum is being baked, voices then render additively
+    currentWavetable = wavetables.getCurrentSet();
+
+    FloatVectorOperations::clear(outL, numSamples);
 
 #ifndef NOEDITOR 
-    // MIDI Input
+    // MIDI Input. Render up to each event and apply it there, so notes start
+    // on their own sample whatever the buffer size is.
     MidiBuffer::Iterator it(midiMessages);
     MidiMessage currentMessage;
     int samplePos;
+    int position = 0;
 
     while (it.getNextEvent(currentMessage, samplePos))
     {
-        if (currentMessage.isNoteOn())
-        {
-            f0 = currentMessage.getMidiNoteInHertz(currentMessage.getNoteNumber(), 440);
-            currentPlayingNotes[currentVoiceIndex] = currentMessage.getNoteNumber();
-            synthVoices[currentVoiceIndex].setF0(f0);
-            synthVoices[currentVoiceIndex].noteOn();
-            currentVoiceIndex++;
-            if (currentVoiceIndex >= numVoices)currentVoiceIndex = 0;
-        }
-        else if (currentMessage.isNoteOff())
-        {
-            for (int i = 0; i < numVoices; i++)
-            {
-                if (currentMessage.getNoteNumber() == currentPlayingNotes[i])
-                {
-                    synthVoices[i].noteOff();
-                }
-            }
-            
-        }
+        samplePos = jlimit(position, numSamples, samplePos);
+        renderVoices(outL + position, samplePos - position, numSamples - position);
+        position = samplePos;
+
+        handleMidiMessage(currentMessage);
     }
+    renderVoices(outL + position, numSamples - position, numSamples - position);
+#else
+    // Unity events, the same way: render up to each one and apply it there
+    noteEvents.beginBlock(numSamples);
+    NoteEvent event;
+    int samplePos;
+    int position = 0;
 
-    for (int i = 0; i < numVoices; i++)
+    while (noteEvents.getNextEvent(event, samplePos))
     {
-        synthVoices[i].cent = cent;
-        synthVoices[i].setAngleChange();
+        samplePos = jlimit(position, numSamples, samplePos);
+        renderVoices(outL + position, samplePos - position, numSamples - position);
+        position = samplePos;
+
+        handleNoteEvent(event);
     }
+    renderVoices(outL + position, numSamples - position, numSamples - position);
+    noteEvents.endBlock();
+#endif
+
+    // ramp from the last volume to the new one, so volume changes don't zipper
+    float gain = vol * (1.f / static_cast<float>(activeVoices));
+    buffer.applyGainRamp(0, 0, numSamples, outputGain, gain);
+    outputGain = gain;
+
+    FloatVectorOperations::clip(outL, outL, -1.f, 1.f, numSamples);
+    FloatVectorOperations::copy(outR, outL, numSamples);
+
+    loadMeter.blockFinished(blockStart, numSamples, blockVoices, blockPartials);
 
+#ifdef NOEDITOR
+    setMeter(cpuLoad, loadMeter.getLoad());
+    setMeter(peakLoad, loadMeter.getPeakLoad());
+    setMeter(activeVoicesMeter, (float)loadMeter.getNumVoices());
+    setMeter(partialsMeter, (float)loadMeter.getNumPartials());
+    setMeter(overruns, (float)loadMeter.getNumOverruns());
 #endif
+}
 
-    #ifdef NOEDITOR     
-        if (vol != *volume)vol = *volume;
-        if (cent != *modulation)
-        {
-            // Check modulation ocne every buffer to allow smooth frequency changes
-            cent = *modulation * 100.0;
-            for (int i = 0; i < numVoices; i++)
-            {
-                synthVoices[i].cent = cent;
-                synthVoices[i].setAngleChange();
-            }
-        }
-        if (att != *attack || dec != *decay || sus != *sustain || rel != *release)
+#ifdef NOEDITOR
+void AdditiveSynthPluginAudioProcessor::updateParameters()
+{
+    if (vol != *volume)vol = *volume;
+    if (modulationValue != *modulation)
+    {
+        // Check modulation ocne every buffer to allow smooth frequency changes
+        modulationValue = *modulation;
+        cent = modulationValue * 100.f;
+        for (int i = 0; i < voiceAllocator.getNumActive(); i++)
         {
-            // Envelope changed
-            att = *attack;
-            dec = *decay;
-            sus = *sustain;
-            rel = *release;
-            for (int i = 0; i < numVoices; i++)  synthVoices[i].setADSRParams({ att,dec,sus,rel });
+            int voice = voiceAllocator.getActiveVoices()[i];
+            synthVoices[voice].cent = cent;
+            synthVoices[voice].setAngleChange();
         }
+    }
+    if (audioADSR.attack != *attack || audioADSR.decay != *decay || audioADSR.sustain != *sustain || audioADSR.release != *release)
+    {
+        // Envelope changed
+        audioADSR = { *attack, *decay, *sustain, *release };
+        for (int i = 0; i < voiceAllocator.getNumActive(); i++)
+            synthVoices[voiceAllocator.getActiveVoices()[i]].setADSRParams(audioADSR);
+    }
 
-        if (currentPreset != *preset)
-        {
-            // Preset is changed
-            currentPreset = *preset;
-            ChangePreset();
-        }
+    if (oscillatorMode != oscillator->getIndex())
+    {
+        // Oscillator engine changed
+        setVoiceOscillatorMode(oscillator->getIndex());
+    }
 
-        for (int i = 0; i < numVoices; i++)
-        {
-            // Check note on and off
-            if (*noteOnOff[i] && !isPlaying[i])
-            {
-                synthVoices[i].noteOn();
-                isPlaying[i] = true; 
-            }
+    if (synthEngine != engine->getIndex())
+    {
+        // Synthesis engine changed
+        setVoiceEngine(engine->getIndex());
+    }
 
-            if (!*noteOnOff[i] && isPlaying[i])
-            {
-                synthVoices[i].noteOff();
-                isPlaying[i] = false;
-            }
-        }
+    if (audioNumHarmonics != *harmonics)
+    {
+        // Patch complexity changed, the preset is rebuilt for the new count
+        audioNumHarmonics = *harmonics;
+        for (int i = 0; i < voiceAllocator.getNumActive(); i++)
+            synthVoices[voiceAllocator.getActiveVoices()[i]].setNumHarmonics(audioNumHarmonics);
+        ChangePreset();
+    }
+
+    if (currentPreset != *preset)
+    {
+        // Preset is changed
+        currentPreset = *preset;
+        ChangePreset();
+    }
+
+    if (parallelRendering != *parallel)parallelRendering = *parallel;
+
+    int target;
+    float amount;
+    unpackMorph(morphSetting, target, amount);
+    if (target != *morphPreset - 1 || amount != *morph)
+        setVoiceMorph(*morphPreset - 1, *morph);
+}
 
-        if (*voiceIsAdded)
+void AdditiveSynthPluginAudioProcessor::handleNoteEvent(const NoteEvent& event)
+{
+    if (event.type == NoteEvent::noteOn)
+    {
+        f0 = jlimit(20.f, 20000.f, event.value);
+        int released;
+        int voice = voiceAllocator.noteOn(event.number, released);
+        if (released >= 0)
+            synthVoices[released].noteOff();
+        setUpVoice(voice);
+        synthVoices[voice].cent = cent;
+        synthVoices[voice].setF0(f0);
+        synthVoices[voice].setAngleChange();
+        synthVoices[voice].setVelocity(jlimit(0.f, 1.f, event.velocity));
+        synthVoices[voice].noteOn();
+    }
+    else if (event.type == NoteEvent::noteOff)
+    {
+        int voice = voiceAllocator.noteOff(event.number);
+        if (voice >= 0)
+            synthVoices[voice].noteOff();
+    }
+    else if (event.type == NoteEvent::parameterChange)
+    {
+        // as if Unity had set it, from this sample on
+        auto& parameters = getParameters();
+        if (event.number >= 0 && event.number < (int)parameters.size())
         {
-            // Voice is added. change the frequency of that voice
-            if (currentVoiceIndex != 0 && activeVoices <= numVoices)activeVoices++;
-            f0 = *fundamentalFreq;                          // change f0 to current frequency
-            synthVoices[currentVoiceIndex].setF0(f0);
-            currentVoiceIndex++;
-            if (currentVoiceIndex >= numVoices)currentVoiceIndex = 0;
-            *voiceIsAdded = false; 
+            parameters[event.number]->setValue(jlimit(0.f, 1.f, event.value));
+            updateParameters();
+            applyMorph();
+            applyModeAndEngine();
         }
+    }
+}
+
+void AdditiveSynthPluginAudioProcessor::setParameterQuietly(RangedAudioParameter* parameter, float value)
+{
+    // the range limits the value
+    static_cast<AudioProcessorParameter*>(parameter)->setValue(parameter->convertTo0to1(value));
+}
+
+void AdditiveSynthPluginAudioProcessor::setMeter(AudioParameterFloat* meter, float value)
+{
+    // Unity polls the values, so the host isn't notified. That would take a
+    // lock on the audio thread for every meter on every block.
+    static_cast<AudioProcessorParameter*>(meter)->setValue(meter->convertTo0to1(jlimit(meter->range.start, meter->range.end, value)));
+}
+#endif
+
+void AdditiveSynthPluginAudioProcessor::handleMidiMessage(const MidiMessage& message)
+{
+    if (message.isNoteOn())
+    {
+        f0 = message.getMidiNoteInHertz(message.getNoteNumber(), 440);
+        int released;
+        int voice = voiceAllocator.noteOn(message.getNoteNumber(), released);
+        if (released >= 0)
+            synthVoices[released].noteOff();
+        setUpVoice(voice);
+        synthVoices[voice].cent = cent;
+        synthVoices[voice].setF0(f0);
+        synthVoices[voice].setAngleChange();
+        synthVoices[voice].noteOn();
+    }
+    else if (message.isNoteOff())
+    {
+        int voice = voiceAllocator.noteOff(message.getNoteNumber());
+        if (voice >= 0)
+            synthVoices[voice].noteOff();
+    }
+}
+
+void AdditiveSynthPluginAudioProcessor::setUpVoice(int voice)
+{
+    Voice& v = synthVoices[voice];
+    v.setNumHarmonics(audioNumHarmonics);
+    v.setSpectrum(audioSpectrum.get());
+    v.setADSRParams(audioADSR);
+    v.setOscillatorMode((OscillatorMode)audioOscillatorMode);
+    v.setEngine((Voice::Engine)audioEngine);
+    v.setMorph(appliedMorphTarget >= 0 ? presetSpectra.getObjectPointer(appliedMorphTarget) : nullptr, appliedMorphAmount);
+}
 
-        if (*resetVoices)
+void AdditiveSynthPluginAudioProcessor::renderVoices(float* out, int numSamples, int rampSamples)
+{
+    if (numSamples <= 0)
+        return;
+
+    // Every sounding voice adds its samples into out, idle voices are not
+    // visited at all
+    int numSounding = 0;
+    int numPartials = 0;
+    for (int i = 0; i < voiceAllocator.getNumActive(); i++)
+    {
+        Voice& voice = synthVoices[voiceAllocator.getActiveVoices()[i]];
+        if (voice.adsr.isActive())
         {
-            // Reset at script start in Unity
-            activeVoices = 1;
-            currentVoiceIndex = 0; 
-            *resetVoices = false;
+            voice.setWavetable(currentWavetable);
+            sounding[numSounding++] = &voice;
+            numPartials += voice.getNumActivePartials();
         }
+    }
 
-    #endif
+    // most over the block, MIDI events split it into several calls
+    blockVoices = jmax(blockVoices, numSounding);
+    blockPartials = jmax(blockPartials, numPartials);
 
-    for (int n = 0; n < buffer.getNumSamples(); ++n)
+    if (parallelRendering && numPartials >= parallelThreshold)
     {
-        auto outL = buffer.getWritePointer(0);
-        auto outR = buffer.getWritePointer(1);
-
-        float x = 0.f;
+        renderPool.render(sounding.data(), numSounding, out, numSamples, rampSamples);
+    }
+    else
+    {
+        // waking the workers costs more than a few voices take to render
+        for (int i = 0; i < numSounding; i++)
+            sounding[i]->renderBlock(out, numSamples, rampSamples);
+    }
 
-        for (int i = 0; i < numVoices; i++)
+    // Voices whose release has ended go back to the free list. They play a
+    // sine until they start again, the pool may delete their spectrum.
+    for (int i = voiceAllocator.getNumActive(); --i >= 0;)
+    {
+        int voice = voiceAllocator.getActiveVoices()[i];
+        if (!synthVoices[voice].adsr.isActive())
         {
-            if (synthVoices[i].adsr.isActive())
-            {
-                x = x + synthVoices[i].getNextSample();
-            }
+            voiceAllocator.voiceFinished(voice);
+            synthVoices[voice].setSpectrum(nullptr);
         }
-        
-        x = vol * (1.f / static_cast<float>(activeVoices)) * x;
-        x = limit(-1.f, 1.f, x);
-        outL[n] = x;
-        outR[n] = x;
     }
 }
 
@@ -365,15 +607,123 @@ juce::AudioProcessorEditor* AdditiveSynthPluginAudioProcessor::createEditor()
 //==============================================================================
 void AdditiveSynthPluginAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    // binary, see Patch.h
+    MemoryOutputStream out(destData, false);
+    getPatch().writeToStream(out);
 }
 
 void AdditiveSynthPluginAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    Patch patch;
+    MemoryInputStream in(data, (size_t)jmax(0, sizeInBytes), false);
+    if (patch.readFromStream(in))
+        setPatch(patch);
+}
+
+Patch AdditiveSynthPluginAudioProcessor::getPatch()
+{
+    Patch patch;
+#ifdef NOEDITOR
+    // The harmonics parameter wins over numHarmonics: it is what plays, and
+    // Unity sets it without going through the message thread
+    int count = *harmonics;
+#else
+    int count = numHarmonics;
+#endif
+    patch.numHarmonics = count;
+    patch.gains.assign(gainVector.begin(), gainVector.begin() + count);
+
+    // harmonic ratios aren't stored
+    for (int h = 0; h < count; h++)
+    {
+        if (ratioVector[h] != h + 1.0)
+        {
+            patch.ratios.assign(ratioVector.begin(), ratioVector.begin() + count);
+            break;
+        }
+    }
+
+    patch.envelopes = partialEnvelopes;
+    if (partialTracks != nullptr)
+        patch.trackFile = partialTracks->getFile().getFullPathName();
+#ifdef NOEDITOR
+    patch.preset = *preset;     // in this build the spectrum is the preset parameter
+    patch.adsr = { *attack, *decay, *sustain, *release };
+#else
+    patch.adsr = { att, dec, sus, rel };
+#endif
+    patch.oscillatorMode = oscillatorMode;
+    patch.engine = synthEngine;
+    patch.numVoices = numVoices;
+    unpackMorph(morphSetting, patch.morphPreset, patch.morphAmount);
+    patch.volume = vol;
+    patch.cent = cent;
+    return patch;
+}
+
+void AdditiveSynthPluginAudioProcessor::readPatch(const Patch& patch)
+{
+    patchChanges++;
+    numHarmonics = jlimit(1, maxHarmonics, patch.numHarmonics);
+
+    // a preset's spectrum comes from the tables, not from the stored gains
+    const double* gains = patch.gains.data();
+    const double* ratios = patch.ratios.size() >= patch.gains.size() ? patch.ratios.data() : nullptr;
+    int count = jmin(maxHarmonics, (int)patch.gains.size());
+    if (patch.preset > 0 && patch.preset <= PresetSpectra::numPresets)
+    {
+        gains = PresetSpectra::get(patch.preset - 1).gains;
+        ratios = PresetSpectra::get(patch.preset - 1).ratios;
+        count = maxHarmonics;
+    }
+
+    // the vectors keep their size, past the patch's partials they go on harmonically
+    for (int h = 0; h < maxHarmonics; h++)
+    {
+        gainVector[h] = h < count ? gains[h] : 0.0;
+        ratioVector[h] = h < count && ratios != nullptr ? ratios[h] : h + 1.0;
+        if (h > 0)
+            ratioVector[h] = jmax(ratioVector[h], ratioVector[h - 1]);
+    }
+
+    partialEnvelopes = patch.envelopes;
+    partialTracks = patch.trackFile.isNotEmpty() ? PartialTrackFile::open(File(patch.trackFile)) : nullptr;
+
+    att = patch.adsr.attack;
+    dec = patch.adsr.decay;
+    sus = patch.adsr.sustain;
+    rel = patch.adsr.release;
+}
+
+void AdditiveSynthPluginAudioProcessor::setPatch(const Patch& patch)
+{
+    readPatch(patch);
+    setNumVoices(patch.numVoices);
+
+#ifdef NOEDITOR
+    // through the parameters, so Unity reads back what plays
+    *volume = patch.volume;
+    *modulation = patch.cent / 100.f;
+    *attack = att;
+    *decay = dec;
+    *sustain = sus;
+    *release = rel;
+    if (patch.preset > 0)
+        *preset = jlimit(1, (int)PresetSpectra::numPresets, patch.preset);
+    *morphPreset = jlimit(1, (int)PresetSpectra::numPresets, patch.morphPreset + 1);
+    *morph = patch.morphPreset >= 0 ? patch.morphAmount : 0.f;
+    *oscillator = jlimit(0, (int)numOscillatorModes - 1, patch.oscillatorMode);
+    *engine = jlimit(0, (int)Voice::numEngines - 1, patch.engine);
+    *harmonics = numHarmonics;
+#else
+    vol = patch.volume;
+    cent = patch.cent;
+    setVoiceOscillatorMode(patch.oscillatorMode);
+    setVoiceEngine(patch.engine);
+    setVoiceMorph(patch.morphPreset, patch.morphAmount);
+#endif
+
+    setVoiceHarmonics();
 }
 
 //==============================================================================
@@ -383,81 +733,251 @@ juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
     return new AdditiveSynthPluginAudioProcessor();
 }
 
-float AdditiveSynthPluginAudioProcessor::limit(float min, float max, float n)
+void AdditiveSynthPluginAudioProcessor::setVoiceHarmonics()
+{
+    if (partialTracks != nullptr)
+        currentSpectrum = spectra.create(partialTracks.get());
+    else
+        currentSpectrum = spectra.create(gainVector.data(), numHarmonics, ratioVector.data(), partialEnvelopes);
+    publishVoiceParameters();
+}
+
+void AdditiveSynthPluginAudioProcessor::setVoiceMorph(int preset, float amount)
 {
-    if (n < -1.f) return -1.f;
-    else if (n > 1.f) return 1.f;
-    else return n;
+    morphSetting = packMorph(jlimit(-1, PresetSpectra::numPresets - 1, preset), jlimit(0.f, 1.f, amount));
 }
 
+int64 AdditiveSynthPluginAudioProcessor::packMorph(int target, float amount)
+{
+    uint32 amountBits;
+    memcpy(&amountBits, &amount, sizeof(amountBits));
+    return (int64)((uint64)(uint32)target << 32 | amountBits);
+}
 
-void AdditiveSynthPluginAudioProcessor::setVoiceHarmonics()
+void AdditiveSynthPluginAudioProcessor::unpackMorph(int64 setting, int& target, float& amount)
 {
-    for (int i = 0; i < numVoices; i++)
-    synthVoices[i].setHarmonicGain(gainVector);
+    target = (int)(int32)(uint32)((uint64)setting >> 32);
+    uint32 amountBits = (uint32)setting;
+    memcpy(&amount, &amountBits, sizeof(amount));
 }
 
-void AdditiveSynthPluginAudioProcessor::setVoiceADSR(float  att, float dec, float sus, float rel)
+void AdditiveSynthPluginAudioProcessor::applyMorph()
 {
-    for (int i = 0; i < numVoices; i++)
-    synthVoices[i].setADSRParams({att,dec,sus,rel});
+    // The preset spectra live as long as the processor, so the voices only
+    // get a pointer and an amount; each voice updates its gains from its
+    // next block, and ramps them over that block
+    int target;
+    float amount;
+    unpackMorph(morphSetting, target, amount);
+    if (target == appliedMorphTarget && amount == appliedMorphAmount)
+        return;
+
+    Spectrum* spectrum = target >= 0 ? presetSpectra.getObjectPointer(target) : nullptr;
+    for (int i = 0; i < voiceAllocator.getNumActive(); i++)
+        synthVoices[voiceAllocator.getActiveVoices()[i]].setMorph(spectrum, amount);
+
+    appliedMorphTarget = target;
+    appliedMorphAmount = amount;
 }
 
-void AdditiveSynthPluginAudioProcessor::ChangePreset()
+void AdditiveSynthPluginAudioProcessor::setVoiceEnvelopes(const PartialEnvelopes& envelopes)
+{
+    partialEnvelopes = envelopes;
+    setVoiceHarmonics();
+}
+
+void AdditiveSynthPluginAudioProcessor::setVoicePartialTracks(PartialTrackFile* tracks)
+{
+    // the file stays mapped until the pool lets go of the last spectrum using it
+    partialTracks = tracks;
+    setVoiceHarmonics();
+}
+
+bool AdditiveSynthPluginAudioProcessor::loadPresetBank(const File& file)
+{
+    PresetBank::Ptr bank = PresetBank::load(file);
+    if (bank == nullptr)
+        return false;
+
+    // The bank's spectra stay out of the pool, the bank cache deletes them
+    // with the bank once no audio thread holds one
+    presetBank = bank;
+
+    publishVoiceParameters();
+    return true;
+}
+
+void AdditiveSynthPluginAudioProcessor::selectPreset(int index)
 {
-    switch (currentPreset)
+    if (presetBank == nullptr || index < 0 || index >= presetBank->size())
+        return;
+
+    // The message thread's copies follow, so later edits and the saved
+    // state start from the preset
+    readPatch(presetBank->getPatch(index));
+    currentSpectrum = presetBank->getSpectrum(index);
+    currentProgram = index;
+
+    pendingPreset = index;
+}
+
+void AdditiveSynthPluginAudioProcessor::applyPreset(int index)
+{
+    // Everything was made when the bank was loaded, the voices get a pointer
+    // to the preset's spectrum and a few numbers. Nothing is allocated, and
+    // it costs what switching a built-in preset costs.
+    if (audioBank == nullptr || index >= audioBank->size())
+        return;
+
+    const Patch& patch = audioBank->getPatch(index);
+    Spectrum* spectrum = audioBank->getSpectrum(index);
+    int count = jlimit(1, maxHarmonics, patch.numHarmonics);
+    ADSR::Parameters adsr = patch.adsr;
+
+    for (int i = 0; i < voiceAllocator.getNumActive(); i++)
     {
-    // Sine wave
-    case 1:
-       
-        for (int h = 0; h < numHarmonics; h++)
-        {
-            gainVector[h] = 0;
-        }
-        gainVector[0] = 1.f;
+        Voice& voice = synthVoices[voiceAllocator.getActiveVoices()[i]];
+        voice.setNumHarmonics(count);
+        voice.setSpectrum(spectrum);
+        voice.setADSRParams(adsr);
+    }
+    audioSpectrum = spectrum;
+    audioNumHarmonics = count;
+    audioADSR = adsr;
+    wavetables.requestBake(spectrum->getGains(), jmin(count, spectrum->getNumHarmonics()));
+    bakedNumHarmonics = count;
 
-        for (int i = 0; i < numVoices; i++)
-            synthVoices[i].setHarmonicGain(gainVector);
-        break;
+    setNumVoices(patch.numVoices);
 
-    // Triangle wave
-    case 2:
+#ifdef NOEDITOR
+    // The parameters are set to the preset too, updateParameters() then
+    // finds nothing changed and applies the rest
+    setParameterQuietly(harmonics, (float)count);
+    setParameterQuietly(attack, adsr.attack);
+    setParameterQuietly(decay, adsr.decay);
+    setParameterQuietly(sustain, adsr.sustain);
+    setParameterQuietly(release, adsr.release);
+    if (patch.preset > 0)
+    {
+        currentPreset = jlimit(1, (int)PresetSpectra::numPresets, patch.preset);
+        setParameterQuietly(preset, (float)currentPreset);
+    }
+    setParameterQuietly(volume, patch.volume);
+    setParameterQuietly(modulation, patch.cent / 100.f);
+    setParameterQuietly(oscillator, (float)patch.oscillatorMode);
+    setParameterQuietly(engine, (float)patch.engine);
+    setParameterQuietly(morphPreset, (float)(patch.morphPreset + 1));
+    setParameterQuietly(morph, patch.morphPreset >= 0 ? patch.morphAmount : 0.f);
+    updateParameters();
+#else
+    vol = patch.volume;
+    cent = patch.cent;
+    setVoiceOscillatorMode(patch.oscillatorMode);
+    setVoiceEngine(patch.engine);
+    setVoiceMorph(patch.morphPreset, patch.morphAmount);
+#endif
+}
 
-        for (int h = 0; h < numHarmonics; h++)
-        {
-            if (isOdd(h))
-                gainVector[h] = 1.0 / (h * h);
-            else gainVector[h] = 0.f;
-        }
+void AdditiveSynthPluginAudioProcessor::setNumHarmonics(int numHarmonics)
+{
+    numHarmonics = jlimit(1, maxHarmonics, numHarmonics);
 
-        for (int i = 0; i < numVoices; i++)
-            synthVoices[i].setHarmonicGain(gainVector);
-        break;
-        
-    // Saw wave
-    case 3:
-        
-        for (int h = 0; h < numHarmonics; h++)
-        {
-            gainVector[h] = 1.0 / (h + 1.0);
-        }
+    // harmonics that come back start silent
+    for (int h = this->numHarmonics; h < numHarmonics; h++)
+        gainVector[h] = 0.0;
 
-        for (int i = 0; i < numVoices; i++)
-            synthVoices[i].setHarmonicGain(gainVector);
-        break;
+    this->numHarmonics = numHarmonics;
+    setVoiceHarmonics();
+}
 
-    // Square wave
-    case 4:
+void AdditiveSynthPluginAudioProcessor::setVoiceADSR(float  att, float dec, float sus, float rel)
+{
+    this->att = att;
+    this->dec = dec;
+    this->sus = sus;
+    this->rel = rel;
+    publishVoiceParameters();
+}
 
-        for (int h = 0; h < numHarmonics; h++)
-        {
-            if (isOdd(h))
-                gainVector[h] = 1.0 / (h + 1.0);
-            else gainVector[h] = 0.f;
-        }
+void AdditiveSynthPluginAudioProcessor::publishVoiceParameters()
+{
+    // no locks, the audio thread reads the last published version
+    VoiceParameters& parameters = voiceParameters.getWriteBuffer();
+
+    parameters.spectrum = currentSpectrum;
+    parameters.numHarmonics = numHarmonics;
+    parameters.adsr = { att, dec, sus, rel };
+    parameters.bank = presetBank;
+
+    voiceParameters.publish();
+
+    // a bank the buffers just let go of may be unused now
+    PresetBank::collectGarbage();
+}
+
+void AdditiveSynthPluginAudioProcessor::applyVoiceParameters(const VoiceParameters& parameters)
+{
+    // Every sounding voice points at the same spectrum, nothing is copied,
+    // idle ones get it when they start. The voices let go of the old one
+    // before audioSpectrum does, and the pool or its preset bank still
+    // holds it, so it is deleted later on the message thread.
+    // Only a new spectrum is baked. A bake makes the current tables invalid
+    // until it is done, so every wavetable voice would go back to additive
+    // rendering for a new envelope.
+    bool spectrumChanged = parameters.spectrum.get() != audioSpectrum.get()
+                        || parameters.numHarmonics != bakedNumHarmonics;
+
+    for (int i = 0; i < voiceAllocator.getNumActive(); i++)
+    {
+        Voice& voice = synthVoices[voiceAllocator.getActiveVoices()[i]];
+        voice.setNumHarmonics(parameters.numHarmonics);
+        voice.setSpectrum(parameters.spectrum.get());
+        voice.setADSRParams(parameters.adsr);
+    }
+    audioSpectrum = parameters.spectrum;
+    audioNumHarmonics = parameters.numHarmonics;
+    audioADSR = parameters.adsr;
+    audioBank = parameters.bank.get();
+
+    // a spectrum streamed from tracks has no gains to bake
+    if (spectrumChanged)
+    {
+        bakedNumHarmonics = parameters.numHarmonics;
+        wavetables.requestBake(audioSpectrum->getGains(), jmin(parameters.numHarmonics, audioSpectrum->getNumHarmonics()));
+    }
+}
+
+void AdditiveSynthPluginAudioProcessor::applyModeAndEngine()
+{
+    // Set from any thread, so the voices are only touched here
+    int mode = oscillatorMode;
+    int engine = synthEngine;
 
-        for (int i = 0; i < numVoices; i++)
-            synthVoices[i].setHarmonicGain(gainVector);
-        break;
+    if (mode != audioOscillatorMode)
+    {
+        for (int i = 0; i < voiceAllocator.getNumActive(); i++)
+            synthVoices[voiceAllocator.getActiveVoices()[i]].setOscillatorMode((OscillatorMode)mode);
+        audioOscillatorMode = mode;
+    }
+
+    if (engine != audioEngine)
+    {
+        for (int i = 0; i < voiceAllocator.getNumActive(); i++)
+            synthVoices[voiceAllocator.getActiveVoices()[i]].setEngine((Voice::Engine)engine);
+        audioEngine = engine;
     }
-}
\ No newline at end of file
+}
+
+void AdditiveSynthPluginAudioProcessor::ChangePreset()
+{
+    // The preset spectra are made up front, so switching only hands every
+    // voice a pointer to one of them
+    Spectrum* spectrum = presetSpectra.getObjectPointer(jlimit(0, presetSpectra.size() - 1, currentPreset - 1));
+
+    for (int i = 0; i < voiceAllocator.getNumActive(); i++)
+        synthVoices[voiceAllocator.getActiveVoices()[i]].setSpectrum(spectrum);
+    audioSpectrum = spectrum;
+
+    wavetables.requestBake(spectrum->getGains(), audioNumHarmonics);
+    bakedNumHarmonics = audioNumHarmonics;
+}
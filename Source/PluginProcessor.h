@@ -12,6 +12,16 @@
 #include <cmath>
 #include <vector>
 #include "SynthVoice.h"
+#include "WavetableBank.h"
+#include "TripleBuffer.h"
+#include "VoiceRenderPool.h"
+#include "VoiceAllocator.h"
+#include "PresetSpectra.h"
+#include "Spectrum.h"
+#include "Patch.h"
+#include "PresetBank.h"
+#include "LoadMeter.h"
+#include "NoteEventQueue.h"
 using namespace std;
 
 
@@ -64,53 +74,167 @@ public:
     float fs = 44100.f;
 
     vector<double> gainVector;
+    vector<double> ratioVector;         // frequency of each partial / f0, ascending, harmonic by default
 
-    float vol = 0.5f; // volume
-    int numHarmonics = 16;
-    int numVoices = 6; 
-    float cent = 0.f;
+    atomic<float> vol { 0.5f }; // volume
+    // Capacity, memory for this many voices and harmonics is allocated once
+    static constexpr int maxHarmonics = 256;
+    static constexpr int maxVoices = 128;
+
+    static_assert(maxHarmonics <= PresetSpectrum::numHarmonics, "presets have to cover every harmonic");
+
+    int numHarmonics = 16;              // message thread, the voices get it through voiceParameters
+    atomic<int> numVoices { jmin(64, maxVoices) };
+
+    // Message thread, up to the capacity and without allocating
+    void setNumHarmonics(int numHarmonics);
+    void setNumVoices(int numVoices) { this->numVoices = jlimit(1, maxVoices, numVoices); }
+    atomic<float> cent { 0.f };
     
+    // Message thread: publish gainVector, ratioVector and the envelope to the audio thread
     void setVoiceHarmonics();
+    void setVoiceEnvelopes(const PartialEnvelopes& envelopes);     // per partial, on top of the ADSR, empty for none
+    // Message thread: the voices play partial tracks instead of gainVector and
+    // ratioVector, from PartialTrackFile::open(), nullptr goes back to those
+    void setVoicePartialTracks(PartialTrackFile* tracks);
+    // Message thread: the whole sound, what the plugin state holds
+    Patch getPatch();
+    void setPatch(const Patch& patch);
+    // Counts the patches and presets loaded, so an editor knows when to show new gains
+    int getPatchChanges() { return patchChanges; }
+    // Message thread: presets shared with every instance that loads the same
+    // file. A selected preset is swapped in at the start of the next block,
+    // the voices only get pointers to what the bank made when it was loaded.
+    bool loadPresetBank(const File& file);
+    void selectPreset(int index);
+    // Any thread: every voice's spectrum morphs towards a preset, preset is a
+    // PresetSpectra::Shape or -1 for none, amount 0 - 1
+    void setVoiceMorph(int preset, float amount);
     void setVoiceADSR(float att, float dec, float sus, float rel);
-    float att = 0.5f, dec = 0.5f, sus = 1.0f, rel = 0.5f;
+    // Any thread, the voices pick them up at the start of the next block
+    void setVoiceOscillatorMode(int mode) { oscillatorMode = jlimit(0, (int)numOscillatorModes - 1, mode); }
+    void setVoiceEngine(int engine) { synthEngine = jlimit(0, (int)Voice::numEngines - 1, engine); }
+    void setVoiceStealing(int policy) { stealPolicy = policy; }
+    float att = 0.5f, dec = 0.5f, sus = 1.0f, rel = 0.5f;     // message thread, like numHarmonics
+    atomic<int> oscillatorMode { sineMode };
+    atomic<int> synthEngine { Voice::oscillatorEngine };
+    atomic<int> stealPolicy { VoiceAllocator::stealOldest };
+
+    // Voices are rendered on worker threads when this is on and the block has
+    // at least parallelThreshold partials over all sounding voices
+    atomic<bool> parallelRendering { true };
+    int parallelThreshold = 512;
+
+    LoadMeter loadMeter;                // block time and voice counts, read from any thread
+#ifdef NOEDITOR
+    NoteEventQueue noteEvents;          // notes and parameter changes from Unity, see UnityBridge.h
+#endif
 private:
     // variables
     float nyquist = fs / 2.f;
     
-    vector<double> currentPlayingNotes;    
     int currentPreset = 1;
 
-    int currentVoiceIndex = 0;
-    vector<SynthVoice> synthVoices;
+    vector<Voice> synthVoices;     // maxVoices, set up in prepareToPlay
+    VoiceArena arena;                   // per-sample data of all voices
+    VoiceAllocator voiceAllocator;      // sounding and free voices, note to voice map
+    float outputGain = 0.f;             // volume at the end of the last block, ramped from
+
+    // Spectrum and envelope as set on the message thread, picked up by
+    // processBlock at the start of a block
+    struct VoiceParameters
+    {
+        Spectrum::Ptr spectrum;
+        int numHarmonics = 0;
+        ADSR::Parameters adsr;
+        PresetBank::Ptr bank;
+    };
+    TripleBuffer<VoiceParameters> voiceParameters;
+
+    SpectrumPool spectra;               // message thread, deletes spectra nobody uses any more
+    Spectrum::Ptr currentSpectrum;      // message thread, made from gainVector, ratioVector and partialEnvelopes
+    PartialEnvelopes partialEnvelopes;  // message thread
+    PartialTrackFile::Ptr partialTracks;    // message thread, nullptr when playing gainVector
+    PresetBank::Ptr presetBank;         // message thread
+    const PresetBank* audioBank = nullptr;  // audio thread, held by the last voice parameters read
+    atomic<int> pendingPreset { -1 };   // index in the bank, picked up by the next block
+    atomic<int> currentProgram { 0 };
+    void readPatch(const Patch& patch);     // into the message thread's copies, never audioNumHarmonics or audioADSR
+    int patchChanges = 0;               // message thread
+    void applyPreset(int index);
+    Spectrum::Ptr audioSpectrum;        // audio thread, what the voices point at
+    int audioNumHarmonics = 16;         // audio thread, what the voices were given
+    ADSR::Parameters audioADSR;
+    int bakedNumHarmonics = 0;          // audio thread, harmonics of the last bake requested
+    ReferenceCountedArray<Spectrum> presetSpectra;
+
+    // Preset and amount in one word, so applyMorph() never sees a new preset
+    // with the old amount: the preset in the upper 32 bits, the amount's
+    // float bits in the lower
+    atomic<int64> morphSetting { packMorph(-1, 0.f) };
+    static int64 packMorph(int target, float amount);
+    static void unpackMorph(int64 setting, int& target, float& amount);
+    int appliedMorphTarget = -1;        // audio thread, what the voices were given
+    float appliedMorphAmount = 0.f;
+    void applyMorph();
+    int audioOscillatorMode = sineMode;     // audio thread, what the voices were given
+    int audioEngine = Voice::oscillatorEngine;
+    void applyModeAndEngine();
+
+    const WavetableSet* currentWavetable = nullptr;     // this block's tables, audio thread
+
+    void handleMidiMessage(const MidiMessage& message);
+    // Audio thread: only the sounding voices follow parameter changes, a
+    // voice that starts gets what they were given while it was idle
+    void setUpVoice(int voice);
+    // Adds the sounding voices to out, ramping over rampSamples, what is left of the block
+    void renderVoices(float* out, int numSamples, int rampSamples);
+    void publishVoiceParameters();
+    void applyVoiceParameters(const VoiceParameters& parameters);
+    WavetableBank wavetables;           // static spectra baked off the audio thread
+
+    VoiceRenderPool renderPool;
+    vector<Voice*> sounding;       // voices rendered this block
+    int blockVoices = 0;                // sounding voices and partials this block, for the meter
+    int blockPartials = 0;
 
 #ifdef NOEDITOR 
         // Exposed parameters for Unity
         AudioParameterFloat* volume;
         AudioParameterFloat* modulation;
-        AudioParameterFloat* fundamentalFreq;
         AudioParameterFloat* attack;
         AudioParameterFloat* decay;
         AudioParameterFloat* sustain;
         AudioParameterFloat* release;
-        AudioParameterBool* resetVoices;
         AudioParameterInt* preset;
-        vector<AudioParameterBool*> noteOnOff; 
-        AudioParameterBool* voiceIsAdded; 
-
-        int activeVoices = 1;
-        vector<bool> isPlaying;
+        AudioParameterInt* morphPreset;
+        AudioParameterFloat* morph;
+        AudioParameterChoice* oscillator;
+        AudioParameterChoice* engine;
+        AudioParameterBool* parallel;
+        AudioParameterInt* harmonics;
+        AudioParameterFloat* instance;      // read-only, id for the functions in UnityBridge.h
+
+        // Read-only meters from loadMeter
+        AudioParameterFloat* cpuLoad;
+        AudioParameterFloat* peakLoad;
+        AudioParameterFloat* activeVoicesMeter;
+        AudioParameterFloat* partialsMeter;
+        AudioParameterFloat* overruns;
+        void setMeter(AudioParameterFloat* meter, float value);
+        void setParameterQuietly(RangedAudioParameter* parameter, float value);    // audio thread, like the meters
+
+        int instanceId = 0;
+        float modulationValue = 0.f;        // audio thread, the modulation parameter cent was set from
+        void updateParameters();            // picks up parameters Unity changed
+        void handleNoteEvent(const NoteEvent& event);
 #endif
 
-#ifndef NOEDITOR
-        // When playing midi 
-        int activeVoices = numVoices;
-#endif
+    // Output is scaled for this many voices at full level
+    int activeVoices = 6;
 
     // methods
-    float limit(float min, float max, float n);
-
     void ChangePreset();
-    bool isOdd(int value) { return value % 2 != 0; };
    
 
     //==============================================================================
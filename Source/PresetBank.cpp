@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+    PresetBank.cpp
+    Created: 25 Oct 2026 11:03:58am
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+#include "PresetSpectra.h"
+
+static constexpr int bankMagic = 0x42505341;       // "ASPB" in the file
+
+// The spectrum a patch plays, as the processor would make it
+static Spectrum::Ptr createSpectrum(const Patch& patch)
+{
+    if (patch.trackFile.isNotEmpty())
+    {
+        PartialTrackFile::Ptr tracks = PartialTrackFile::open(File(patch.trackFile));
+        if (tracks != nullptr)
+            return new Spectrum(tracks.get());
+    }
+
+    if (patch.preset > 0 && patch.preset <= PresetSpectra::numPresets)
+    {
+        const PresetSpectrum& preset = PresetSpectra::get(patch.preset - 1);
+        return new Spectrum(preset.gains, PresetSpectrum::numHarmonics, preset.ratios, patch.envelopes);
+    }
+
+    const double* ratios = patch.ratios.size() >= patch.gains.size() ? patch.ratios.data() : nullptr;
+    return new Spectrum(patch.gains.data(), (int)patch.gains.size(), ratios, patch.envelopes);
+}
+
+PresetBank::PresetBank(const File& file)
+    : file(file), modificationTime(file.getLastModificationTime())
+{
+}
+
+// Every bank that was loaded, until collectGarbage() finds it unused
+static CriticalSection& getCacheLock()
+{
+    static CriticalSection lock;
+    return lock;
+}
+
+static ReferenceCountedArray<PresetBank>& getCache()
+{
+    static ReferenceCountedArray<PresetBank> loaded;
+    return loaded;
+}
+
+PresetBank::Ptr PresetBank::load(const File& file)
+{
+    collectGarbage();
+    const ScopedLock scopedLock(getCacheLock());
+
+    for (auto* bank : getCache())
+    {
+        if (bank->file == file && bank->modificationTime == file.getLastModificationTime())
+            return bank;
+    }
+
+    // one read of the whole file, then parsed from memory
+    MemoryBlock data;
+    if (!file.loadFileAsData(data))
+        return nullptr;
+
+    Ptr bank = new PresetBank(file);
+    MemoryInputStream in(data, false);
+    if (!bank->readFromStream(in))
+        return nullptr;
+
+    getCache().add(bank);
+    return bank;
+}
+
+void PresetBank::collectGarbage()
+{
+    const ScopedLock scopedLock(getCacheLock());
+
+    ReferenceCountedArray<PresetBank>& loaded = getCache();
+    for (int i = loaded.size(); --i >= 0;)
+    {
+        if (!loaded.getObjectPointerUnchecked(i)->isInUse())
+            loaded.remove(i);
+    }
+}
+
+bool PresetBank::isInUse() const
+{
+    // A count of 1 is the cache. Nothing else holds the bank, so no audio
+    // thread can take one of its spectra any more, only the ones it still
+    // holds are left: their count is 1 for the bank plus those.
+    if (getReferenceCount() > 1)
+        return true;
+
+    for (const Preset& preset : presets)
+    {
+        if (preset.spectrum->getReferenceCount() > 1)
+            return true;
+    }
+    return false;
+}
+
+bool PresetBank::readFromStream(InputStream& in)
+{
+    if (in.readInt() != bankMagic || in.readInt() < 1)
+        return false;
+
+    int count = in.readInt();
+    if (count < 0 || count > in.getNumBytesRemaining())
+        return false;
+
+    presets.resize(count);
+    for (Preset& preset : presets)
+    {
+        preset.name = in.readString();
+
+        // patches are stored with their size, a newer and longer one is skipped to its end
+        int size = in.readInt();
+        int64 end = in.getPosition() + size;
+        if (size < 0 || size > in.getNumBytesRemaining() || !preset.patch.readFromStream(in))
+            return false;
+        in.setPosition(end);
+
+        preset.spectrum = createSpectrum(preset.patch);
+    }
+    return true;
+}
+
+bool PresetBank::write(const File& file, const StringArray& names, const vector<Patch>& patches)
+{
+    jassert(names.size() == (int)patches.size());
+
+    MemoryOutputStream out;
+    out.writeInt(bankMagic);
+    out.writeInt(version);
+    out.writeInt((int)patches.size());
+
+    for (size_t i = 0; i < patches.size(); i++)
+    {
+        out.writeString(names[(int)i]);
+
+        MemoryOutputStream patch;
+        patches[i].writeToStream(patch);
+        out.writeInt((int)patch.getDataSize());
+        out.write(patch.getData(), patch.getDataSize());
+    }
+
+    return file.replaceWithData(out.getData(), out.getDataSize());
+}
@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    PresetBank.h
+    Created: 25 Oct 2026 11:03:58am
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+#include "Patch.h"
+#include "Spectrum.h"
+using namespace std;
+
+// Presets read from a file once and shared by every instance. Loading builds
+// the spectrum of each preset up front, so switching to one only hands the
+// voices a pointer and a few numbers. Every processor that loads the same
+// file gets the same bank, a scene with dozens of instances reads and
+// builds it once. Never changed after loading, so any thread can read it.
+//
+// File: "ASPB", a version and the number of presets, then per preset its
+// name and a Patch (see Patch.h), all little-endian.
+class PresetBank : public ReferenceCountedObject {
+
+public:
+    typedef ReferenceCountedObjectPtr<PresetBank> Ptr;
+
+    static constexpr int version = 1;
+
+    // Read on the first call, shared after that until the file changes.
+    // nullptr when it isn't a bank. Message thread.
+    static Ptr load(const File& file);
+    // Message thread. Deletes the banks no instance holds any more, once no
+    // audio thread holds one of their spectra either, so the last reference
+    // to a bank's spectrum is never let go of on an audio thread. load()
+    // does this too.
+    static void collectGarbage();
+    static bool write(const File& file, const StringArray& names, const vector<Patch>& patches);
+
+    int size() const { return (int)presets.size(); }
+    const String& getName(int index) const { return presets[index].name; }
+    const Patch& getPatch(int index) const { return presets[index].patch; }
+    Spectrum* getSpectrum(int index) const { return presets[index].spectrum.get(); }
+
+private:
+    PresetBank(const File& file);
+    bool readFromStream(InputStream& in);
+    bool isInUse() const;               // by an instance or one of its voices
+
+    struct Preset
+    {
+        String name;
+        Patch patch;
+        Spectrum::Ptr spectrum;         // made from the patch when the bank is loaded
+    };
+
+    File file;
+    Time modificationTime;              // of the file when it was read
+    vector<Preset> presets;
+
+    JUCE_DECLARE_NON_COPYABLE(PresetBank)
+};
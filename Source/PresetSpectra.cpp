@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    PresetSpectra.cpp
+    Created: 19 Oct 2026 10:12:27am
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#include "PresetSpectra.h"
+
+namespace PresetSpectra
+{
+    // Evaluated by the compiler, the binary only contains the finished tables
+    static constexpr PresetSpectrum presets[numPresets] =
+    {
+        makeSpectrum("Sine", sine),
+        makeSpectrum("Triangle", triangle),
+        makeSpectrum("Saw", saw),
+        makeSpectrum("Square", square),
+        makeSpectrum("Pulse", pulse),
+        makeSpectrum("Soft Saw", softSaw),
+        makeSpectrum("Organ", organ),
+        makeSpectrum("Clarinet", clarinet),
+        makeSpectrum("Hollow", hollow),
+        makeSpectrum("Vowel", vowel),
+        makeSpectrum("Octaves", octaves),
+        makeSpectrum("Comb", comb),
+        makeSpectrum("Piano", piano),
+        makeSpectrum("Stiff String", stiffString),
+        makeSpectrum("Bell", bell)
+    };
+
+    static_assert(presets[square].gains[2] == 1.0 / 3.0 && presets[square].gains[1] == 0.0,
+                  "preset tables have to be built at compile time");
+    static_assert(presets[piano].ratios[0] == 1.0 && presets[piano].ratios[1] > 2.0 && presets[bell].ratios[0] == 0.5,
+                  "partial ratios are relative to the fundamental");
+
+    const PresetSpectrum& get(int index)
+    {
+        if (index < 0 || index >= numPresets)
+            index = sine;
+
+        return presets[index];
+    }
+}
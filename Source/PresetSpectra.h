@@ -0,0 +1,142 @@
+/*
+  ==============================================================================
+
+    PresetSpectra.h
+    Created: 19 Oct 2026 10:12:27am
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#pragma once
+
+// Partial gains and frequencies of the built-in presets. The tables are
+// filled in by the compiler (see PresetSpectra.cpp), so choosing a preset only
+// hands the voices a pointer to one of them. Gains are magnitudes, all
+// partials start in phase.
+struct PresetSpectrum
+{
+    static constexpr int numHarmonics = 256;
+
+    const char* name;
+    double gains[numHarmonics];         // gains[h] is partial h
+    double ratios[numHarmonics];        // frequency of partial h / f0, ascending, h + 1 when harmonic
+};
+
+namespace PresetSpectra
+{
+    enum Shape
+    {
+        sine = 0,
+        triangle,           // odd harmonics, 1 / n^2
+        saw,                // all harmonics, 1 / n
+        square,             // odd harmonics, 1 / n
+        pulse,              // 25% duty cycle
+        softSaw,            // all harmonics, 1 / n^2
+        organ,              // drawbar style registration
+        clarinet,           // odd harmonics with a soft rolloff
+        hollow,             // fundamental plus even harmonics
+        vowel,              // resonance around the 5th harmonic
+        octaves,            // only harmonics 1, 2, 4, 8, ...
+        comb,               // saw without every third harmonic
+        piano,              // slightly stretched partials of a piano string
+        stiffString,        // strongly stretched, like a thick metal string
+        bell,               // church bell partials, hum note an octave down
+        numPresets
+    };
+
+    constexpr double squareRoot(double x)
+    {
+        // Newton's method, std::sqrt isn't constexpr
+        if (x <= 0.0)
+            return 0.0;
+
+        double root = x > 1.0 ? x : 1.0;
+        for (int i = 0; i < 100; i++)
+        {
+            double next = 0.5 * (root + x / root);
+            if (next == root)
+                break;
+            root = next;
+        }
+        return root;
+    }
+
+    // Frequency of a stiff string's partial n over its fundamental, with
+    // inharmonicity coefficient b (Fletcher)
+    constexpr double getStretchedRatio(int n, double b)
+    {
+        return n * squareRoot(1.0 + b * n * n) / squareRoot(1.0 + b);
+    }
+
+    // Tuned church bell: hum, prime, tierce, quint, nominal and the partials above
+    constexpr double bellRatios[] = { 0.5, 1.0, 1.2, 1.5, 2.0, 2.5, 2.667, 3.0, 4.0, 5.333 };
+    constexpr double bellGains[] = { 0.6, 0.8, 0.7, 0.3, 1.0, 0.5, 0.3, 0.4, 0.25, 0.15 };
+    constexpr int numBellPartials = 10;
+
+    // Gain of harmonic n (1 is the fundamental) for a shape
+    constexpr double getGain(Shape shape, int n)
+    {
+        switch (shape)
+        {
+        case sine:      return n == 1 ? 1.0 : 0.0;
+        case triangle:  return n % 2 == 1 ? 1.0 / (n * n) : 0.0;
+        case saw:       return 1.0 / n;
+        case square:    return n % 2 == 1 ? 1.0 / n : 0.0;
+        case pulse:     return (n % 4 == 0 ? 0.0 : n % 4 == 2 ? 1.0 : 0.7071067811865476) / n;     // |sin(pi n / 4)| / n
+        case softSaw:   return 1.0 / (n * n);
+        case organ:
+            switch (n)
+            {
+            case 1:  return 1.0;
+            case 2:  return 0.8;
+            case 3:  return 0.6;
+            case 4:  return 0.5;
+            case 6:  return 0.4;
+            case 8:  return 0.3;
+            default: return 0.0;
+            }
+        case clarinet:  return n % 2 == 1 ? 1.0 / (n * (1.0 + n * n / 64.0)) : 0.0;
+        case hollow:    return n == 1 ? 1.0 : n % 2 == 0 ? 1.0 / n : 0.0;
+        case vowel:     return 1.0 / (1.0 + (n - 5) * (n - 5) / 2.0) + (n == 1 ? 0.5 : 0.0);
+        case octaves:
+        {
+            // 1 / (octave + 1) when n is a power of two
+            int octave = 0;
+            while (n % 2 == 0) { n /= 2; octave++; }
+            return n == 1 ? 1.0 / (octave + 1) : 0.0;
+        }
+        case comb:      return n % 3 == 0 ? 0.0 : 1.0 / n;
+        case piano:     return 1.0 / (n * (1.0 + n * n / 100.0));      // the hammer damps the high partials
+        case stiffString: return 1.0 / n;
+        case bell:      return n <= numBellPartials ? bellGains[n - 1] : 0.0;
+        default:        return 0.0;
+        }
+    }
+
+    // Frequency of partial n (1 is the first) over f0 for a shape
+    constexpr double getRatio(Shape shape, int n)
+    {
+        switch (shape)
+        {
+        case piano:       return getStretchedRatio(n, 0.0004);
+        case stiffString: return getStretchedRatio(n, 0.004);
+        case bell:        return n <= numBellPartials ? bellRatios[n - 1] : bellRatios[numBellPartials - 1] + n - numBellPartials;
+        default:          return n;
+        }
+    }
+
+    constexpr PresetSpectrum makeSpectrum(const char* name, Shape shape)
+    {
+        PresetSpectrum spectrum { name, {}, {} };
+        for (int h = 0; h < PresetSpectrum::numHarmonics; h++)
+        {
+            spectrum.gains[h] = getGain(shape, h + 1);
+            spectrum.ratios[h] = getRatio(shape, h + 1);
+        }
+        return spectrum;
+    }
+
+    // index is a Shape, out of range indices give the sine
+    const PresetSpectrum& get(int index);
+}
@@ -0,0 +1,189 @@
+/*
+  ==============================================================================
+
+    SpectralSynth.cpp
+    Created: 17 Oct 2026 1:12:20pm
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#include "SpectralSynth.h"
+
+SpectralSynth::SpectralSynth()
+{
+    kernelTable = &getKernelTable();
+    getFFT();
+}
+
+const dsp::FFT& SpectralSynth::getFFT()
+{
+    static const dsp::FFT fft(fftOrder);
+    return fft;
+}
+
+const vector<float>& SpectralSynth::getKernelTable()
+{
+    // Spectrum of the (zero phase) Hann window, sampled finely between
+    // -kernelRadius - 1 and kernelRadius + 1 bins. It is real because the
+    // window is symmetric around the centre of the frame.
+    static const vector<float> table = []
+    {
+        int tableSize = 2 * (kernelRadius + 1) * kernelOversampling + 1;
+        vector<float> t(tableSize);
+
+        for (int i = 0; i < tableSize; i++)
+        {
+            double offset = (double)i / kernelOversampling - (kernelRadius + 1);
+            double sum = 0.0;
+            for (int n = -frameSize / 2 + 1; n < frameSize / 2; n++)
+            {
+                double window = 0.5 + 0.5 * cos(2.0 * double_Pi * n / frameSize);
+                sum += window * cos(2.0 * double_Pi * offset * n / frameSize);
+            }
+            t[i] = (float)sum;
+        }
+        return t;
+    }();
+    return table;
+}
+
+void SpectralSynth::setup(int maxPartials, VoiceArena* arena)
+{
+    this->maxPartials = maxPartials;
+
+    if (arena != nullptr)
+    {
+        ownMemory.clear();
+        phase = arena->take<double>(maxPartials);
+        frame = arena->take<float>(2 * frameSize);
+        overlapAdd = arena->take<float>(frameSize);
+        gain = arena->take<float>(maxPartials);
+        increment = arena->take<float>(maxPartials);
+    }
+    else
+    {
+        // the float arrays live in double sized slots, two to a slot
+        ownMemory.assign(maxPartials + (3 * frameSize + 2 * maxPartials + 1) / 2, 0.0);
+        phase = ownMemory.data();
+        frame = reinterpret_cast<float*>(phase + maxPartials);
+        overlapAdd = frame + 2 * frameSize;
+        gain = overlapAdd + frameSize;
+        increment = gain + maxPartials;
+    }
+
+    fill(phase, phase + maxPartials, 0.0);
+    fill(gain, gain + maxPartials, 0.f);
+    fill(increment, increment + maxPartials, 0.f);
+    FloatVectorOperations::clear(overlapAdd, frameSize);
+    numPartials = maxPartials;
+    readIndex = hopSize;
+}
+
+size_t SpectralSynth::getMemorySize(int maxPartials)
+{
+    return VoiceArena::roundUp(maxPartials * sizeof(double))
+         + VoiceArena::roundUp(2 * frameSize * sizeof(float))
+         + VoiceArena::roundUp(frameSize * sizeof(float))
+         + 2 * VoiceArena::roundUp(maxPartials * sizeof(float));
+}
+
+void SpectralSynth::setNumPartials(int numPartials)
+{
+    this->numPartials = jlimit(0, maxPartials, numPartials);
+}
+
+void SpectralSynth::setGain(int index, float gain)
+{
+    this->gain[index] = gain;
+}
+
+void SpectralSynth::setIncrement(int index, float increment)
+{
+    this->increment[index] = increment;
+}
+
+void SpectralSynth::resetPhases()
+{
+    fill(phase, phase + maxPartials, 0.0);
+}
+
+void SpectralSynth::render(float* out, int numSamples)
+{
+    int n = 0;
+    while (n < numSamples)
+    {
+        if (readIndex == hopSize)
+        {
+            synthesizeFrame();
+            readIndex = 0;
+        }
+
+        int count = jmin(numSamples - n, hopSize - readIndex);
+        FloatVectorOperations::add(out + n, overlapAdd + readIndex, count);
+        readIndex += count;
+        n += count;
+    }
+}
+
+void SpectralSynth::synthesizeFrame()
+{
+    // the second half of the last frame moves to the front
+    FloatVectorOperations::copy(overlapAdd, overlapAdd + hopSize, frameSize - hopSize);
+    FloatVectorOperations::clear(overlapAdd + frameSize - hopSize, hopSize);
+
+    FloatVectorOperations::clear(frame, 2 * frameSize);
+
+    for (int p = 0; p < numPartials; p++)
+    {
+        float partialIncrement = increment[p] * pitchRatio;
+        if (gain[p] != 0.f)
+        {
+            addPartial(gain[p], phase[p], partialIncrement * frameSize);
+        }
+
+        // phase at the centre of the next frame
+        phase[p] += (double)partialIncrement * hopSize;
+        phase[p] -= floor(phase[p]);
+    }
+
+    getFFT().performRealOnlyInverseTransform(frame);
+    FloatVectorOperations::add(overlapAdd, frame, frameSize);
+}
+
+void SpectralSynth::addPartial(double gain, double phase, double bin)
+{
+    // A windowed g * sin(2 pi phase + ...) has the spectrum
+    //   g / 2j * (e^(j 2 pi phase) W(k - bin) - e^(-j 2 pi phase) W(k + bin))
+    // The (-1)^k factor moves the centre of the window to the middle of the frame.
+    double s = 0.5 * gain * sin(2.0 * double_Pi * phase);
+    double c = 0.5 * gain * cos(2.0 * double_Pi * phase);
+
+    int firstBin = jmax(0, (int)ceil(bin - kernelRadius));
+    int lastBin = jmin(frameSize / 2, (int)floor(bin + kernelRadius));
+
+    for (int k = firstBin; k <= lastBin; k++)
+    {
+        float w = (k & 1) ? -getKernel(k - bin) : getKernel(k - bin);
+        frame[2 * k] += (float)(w * s);
+        frame[2 * k + 1] -= (float)(w * c);
+    }
+
+    // low partials also reach the bins around 0 with their negative frequency
+    for (int k = 0; k <= kernelRadius - bin; k++)
+    {
+        float w = (k & 1) ? -getKernel(k + bin) : getKernel(k + bin);
+        frame[2 * k] += (float)(w * s);
+        frame[2 * k + 1] += (float)(w * c);
+    }
+}
+
+float SpectralSynth::getKernel(double offset)
+{
+    // linear interpolation in the oversampled table
+    double position = (offset + kernelRadius + 1) * kernelOversampling;
+    int index = (int)position;
+    float fraction = (float)(position - index);
+    const vector<float>& table = *kernelTable;
+    return table[index] + fraction * (table[index + 1] - table[index]);
+}
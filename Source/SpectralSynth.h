@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    SpectralSynth.h
+    Created: 17 Oct 2026 1:12:20pm
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+#include "VoiceArena.h"
+using namespace std;
+
+// Additive synthesis with an inverse FFT (FFT^-1, Rodet & Depalle). Every
+// frame each partial adds the spectrum of a windowed sinusoid to a few bins
+// around its frequency, one inverse FFT turns the spectrum into a windowed
+// frame, and frames are overlap-added with 50% overlap. The cost per partial
+// is a handful of bins per frame instead of a sine per sample, so hundreds
+// of partials per voice are affordable.
+//
+// Same interface as OscillatorBank: partials are set with a gain and an
+// increment in cycles per sample, render() adds to the output.
+class SpectralSynth {
+
+public:
+    SpectralSynth();
+
+    static constexpr int fftOrder = 9;                  // 512 point frames
+    static constexpr int frameSize = 1 << fftOrder;
+    static constexpr int hopSize = frameSize / 2;       // Hann windows add up to 1 at this hop
+    static constexpr int kernelRadius = 6;              // bins on each side of a partial
+
+    // Like OscillatorBank, the frame and the partial arrays are taken from
+    // the arena when there is one. getMemorySize() is what they take.
+    void setup(int maxPartials, VoiceArena* arena = nullptr);
+    static size_t getMemorySize(int maxPartials);
+    void setNumPartials(int numPartials);
+    int getNumPartials() { return numPartials; }
+
+    void setGain(int index, float gain);
+    void setIncrement(int index, float increment);      // cycles per sample, at a pitch ratio of 1
+    void setPitchRatio(float ratio) { pitchRatio = ratio; }     // all partials, from the next frame
+    void resetPhases();
+
+    void render(float* out, int numSamples);            // adds the sum of all partials to out
+
+private:
+    void synthesizeFrame();
+    void addPartial(double gain, double phase, double bin);
+    float getKernel(double offset);                     // window spectrum, offset in bins
+
+    // Shared by all voices, built once on first use
+    static const dsp::FFT& getFFT();
+    static const vector<float>& getKernelTable();       // Hann window spectrum around 0, oversampled
+
+    float* frame = nullptr;         // 2 * frameSize, interleaved spectrum, then the frame
+    float* overlapAdd = nullptr;    // frameSize, output still to be played
+    const vector<float>* kernelTable = nullptr;
+
+    float* gain = nullptr;
+    float* increment = nullptr;
+    double* phase = nullptr;        // cycles, at the centre of the next frame
+    vector<double> ownMemory;       // when there is no arena
+
+    float pitchRatio = 1.f;
+    int maxPartials = 0;
+    int numPartials = 0;
+    int readIndex = hopSize;        // a new frame is needed when this reaches hopSize
+
+    static constexpr int kernelOversampling = 64;
+};
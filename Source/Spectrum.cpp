@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    Spectrum.cpp
+    Created: 20 Oct 2026 9:36:12am
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#include "Spectrum.h"
+
+Spectrum::Spectrum(const double* gains, int numHarmonics, const double* ratios, const PartialEnvelopes& envelopes)
+    : gains(gains, gains + jmax(numHarmonics, 0)), envelopes(envelopes)
+{
+    totals.resize(this->gains.size());
+    this->ratios.resize(this->gains.size());
+
+    double total = 0.0;
+    for (size_t h = 0; h < this->gains.size(); h++)
+    {
+        total += this->gains[h];
+        totals[h] = total;
+
+        this->ratios[h] = ratios != nullptr ? ratios[h] : h + 1.0;
+        if (this->ratios[h] != h + 1.0)
+            harmonic = false;
+
+        jassert(h == 0 || this->ratios[h] >= this->ratios[h - 1]);     // voices find the audible partials in order
+    }
+}
+
+Spectrum::Spectrum(PartialTrackFile* tracks)
+    : harmonic(false), tracks(tracks)
+{
+    jassert(tracks != nullptr);
+}
+
+double Spectrum::getTotal(int numHarmonics) const
+{
+    numHarmonics = jmin(numHarmonics, (int)totals.size());
+    return numHarmonics > 0 ? totals[numHarmonics - 1] : 0.0;
+}
+
+//==============================================================================
+SpectrumPool::SpectrumPool()
+{
+}
+
+SpectrumPool::~SpectrumPool()
+{
+}
+
+Spectrum::Ptr SpectrumPool::create(const double* gains, int numHarmonics, const double* ratios, const PartialEnvelopes& envelopes)
+{
+    collectGarbage();
+
+    Spectrum::Ptr spectrum = new Spectrum(gains, numHarmonics, ratios, envelopes);
+    spectra.add(spectrum);
+    return spectrum;
+}
+
+Spectrum::Ptr SpectrumPool::create(PartialTrackFile* tracks)
+{
+    collectGarbage();
+
+    Spectrum::Ptr spectrum = new Spectrum(tracks);
+    spectra.add(spectrum);
+    return spectrum;
+}
+
+void SpectrumPool::collectGarbage()
+{
+    // a count of 1 is the pool itself
+    for (int i = spectra.size(); --i >= 0;)
+    {
+        if (spectra.getObjectPointerUnchecked(i)->getReferenceCount() == 1)
+            spectra.remove(i);
+    }
+}
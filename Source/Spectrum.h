@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    Spectrum.h
+    Created: 20 Oct 2026 9:36:12am
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+#include "PartialEnvelopes.h"
+#include "PartialTrackFile.h"
+using namespace std;
+
+// Partial gains and frequency ratios shared by all voices, and optionally
+// how each gain changes over a note. Never changed after construction, so any thread can
+// read it, and every voice reads the same memory. The running totals of the
+// gains are computed once here, which makes a voice's normalisation a lookup
+// instead of a sum over its harmonics. A spectrum made from partial tracks
+// has no gains or ratios of its own, voices stream them from the tracks.
+class Spectrum : public ReferenceCountedObject {
+
+public:
+    typedef ReferenceCountedObjectPtr<Spectrum> Ptr;
+
+    // Ratios are partial frequency / f0 and have to be ascending, nullptr
+    // makes partial h harmonic h + 1
+    Spectrum(const double* gains, int numHarmonics, const double* ratios = nullptr,
+             const PartialEnvelopes& envelopes = PartialEnvelopes());
+    explicit Spectrum(PartialTrackFile* tracks);
+
+    int getNumHarmonics() const { return (int)gains.size(); }
+    const double* getGains() const { return gains.data(); }
+    double getGain(int harmonic) const { return harmonic < (int)gains.size() ? gains[harmonic] : 0.0; }
+    double getRatio(int harmonic) const { return harmonic < (int)ratios.size() ? ratios[harmonic] : harmonic + 1.0; }
+    const double* getRatios() const { return ratios.data(); }
+    bool isHarmonic() const { return harmonic; }        // every ratio is a whole number, so it fits in a wavetable
+
+    double getTotal(int numHarmonics) const;    // sum of the first numHarmonics gains
+
+    const PartialEnvelopes* getEnvelopes() const { return envelopes.isEmpty() ? nullptr : &envelopes; }
+    const PartialTrackFile* getTracks() const { return tracks.get(); }     // nullptr for a static spectrum
+
+private:
+    vector<double> gains;
+    vector<double> totals;          // totals[h] is the sum of gains[0..h]
+    vector<double> ratios;
+    bool harmonic = true;
+    PartialEnvelopes envelopes;
+    PartialTrackFile::Ptr tracks;   // unmapped with the spectrum, on the message thread
+
+    JUCE_DECLARE_NON_COPYABLE(Spectrum)
+};
+
+// Owns every spectrum that was handed out. The audio thread only ever lets go
+// of a reference while the pool still holds one, so a spectrum is never
+// deleted there: create() deletes the ones nobody else uses any more, on the
+// thread that calls it. Message thread only.
+class SpectrumPool {
+
+public:
+    SpectrumPool();
+    ~SpectrumPool();
+
+    Spectrum::Ptr create(const double* gains, int numHarmonics, const double* ratios = nullptr,
+                         const PartialEnvelopes& envelopes = PartialEnvelopes());
+    Spectrum::Ptr create(PartialTrackFile* tracks);
+    void collectGarbage();
+
+    int size() { return spectra.size(); }
+
+private:
+    ReferenceCountedArray<Spectrum> spectra;
+
+    JUCE_DECLARE_NON_COPYABLE(SpectrumPool)
+};
@@ -10,106 +10,588 @@
 
 #include "SynthVoice.h"
 
-SynthVoice::SynthVoice()
-{
+// Spectrum of a voice that wasn't given one
+static const double fundamentalOnly[] = { 1.0 };
+static const Spectrum sineSpectrum(fundamentalOnly, 1);
 
+template <typename SampleType>
+SynthVoice<SampleType>::SynthVoice()
+{
+    spectrum = &sineSpectrum;
 }
 
-SynthVoice::~SynthVoice()
+template <typename SampleType>
+SynthVoice<SampleType>::~SynthVoice()
 {
 
 }
 
-void SynthVoice::setup(double Fs, int numHarmonics)
+template <typename SampleType>
+void SynthVoice<SampleType>::setup(double Fs, int maxHarmonics, int maxBlockSize, VoiceArena* arena)
 {
     this->Fs = Fs;
-    this->numHarmonics = numHarmonics;
+    this->maxHarmonics = maxHarmonics;
+    this->numHarmonics = maxHarmonics;
 
     nyquist = Fs / 2.f;
 
-    // initialize all vectors:
-    gainVector.clear();
-    currentAngle.clear();
-    angleChange.clear();
+    spectrum = &sineSpectrum;
+    envelopes = nullptr;
+    tracks = nullptr;
+    morphTarget = nullptr;
+    morphAmount = 0.f;
+    morphChanged = false;
+    harmonicRatios = true;
 
-    for (int h = 0; h < numHarmonics; h++)
+    // per-sample data goes into the arena when there is one, a voice that
+    // doesn't fit in it any more allocates all of its own memory instead
+    if (arena != nullptr && !arena->hasRoom(getMemorySize(maxHarmonics, maxBlockSize)))
     {
-        gainVector.push_back(0.f);
-        currentAngle.push_back(0.f);
-        angleChange.push_back(f0 * (h + 1) * 2.f * double_Pi * (1.f / Fs));
+        jassertfalse;
+        arena = nullptr;
     }
 
-    gainVector[0] = 1.f;
+    voiceBufferSize = jmax(maxBlockSize, 1);
+    if (arena != nullptr)
+    {
+        ownBuffer.clear();
+        voiceBuffer = arena->take<float>(voiceBufferSize);
+        envelopeBuffer = arena->take<float>(voiceBufferSize);
+        trackRatios = arena->take<float>(maxHarmonics);
+        trackGains = arena->take<float>(maxHarmonics);
+        activeHarmonics = arena->take<int>(maxHarmonics);
+        harmonicSlot = arena->take<int>(maxHarmonics);
+        previousSlot = arena->take<int>(maxHarmonics);
+    }
+    else
+    {
+        // the int arrays live in float sized slots
+        ownBuffer.assign(2 * voiceBufferSize + 5 * maxHarmonics, 0.f);
+        voiceBuffer = ownBuffer.data();
+        envelopeBuffer = voiceBuffer + voiceBufferSize;
+        trackRatios = envelopeBuffer + voiceBufferSize;
+        trackGains = trackRatios + maxHarmonics;
+        activeHarmonics = reinterpret_cast<int*>(trackGains + maxHarmonics);
+        harmonicSlot = activeHarmonics + maxHarmonics;
+        previousSlot = harmonicSlot + maxHarmonics;
+    }
+    fill(trackRatios, trackRatios + maxHarmonics, 0.f);
+    fill(trackGains, trackGains + maxHarmonics, 0.f);
+    fill(activeHarmonics, activeHarmonics + maxHarmonics, 0);
+    fill(harmonicSlot, harmonicSlot + maxHarmonics, -1);
+    fill(previousSlot, previousSlot + maxHarmonics, -1);
+
+    oscillators.setup(maxHarmonics, maxBlockSize, arena);
+    partialEnvelopes.setup(maxHarmonics, arena);
+    spectral.setup(maxHarmonics, arena);
+
+    numActive = 0;
+    numAudible = -1;
+    partialsF0 = -1.0;
+
+    setAngleChange();
+    tableIncrement = targetTableIncrement;
+
     adsr.setSampleRate(Fs);
     adsr.setParameters({ 0.5f,0.5f,1.0f,0.5f });
+}
 
-    computeAverageGain();
+template <typename SampleType>
+size_t SynthVoice<SampleType>::getMemorySize(int maxHarmonics, int maxBlockSize)
+{
+    return OscillatorBank<SampleType>::getMemorySize(maxHarmonics, maxBlockSize)
+         + PartialEnvelopeState::getMemorySize(maxHarmonics)
+         + SpectralSynth::getMemorySize(maxHarmonics)
+         + 2 * VoiceArena::roundUp(jmax(maxBlockSize, 1) * sizeof(float))
+         + 2 * VoiceArena::roundUp(maxHarmonics * sizeof(float))
+         + 3 * VoiceArena::roundUp(maxHarmonics * sizeof(int));
 }
 
-double SynthVoice::getNextSample()
+template <typename SampleType>
+void SynthVoice<SampleType>::setNumHarmonics(int numHarmonics)
 {
-    double out = 0.f;
+    numHarmonics = jlimit(1, maxHarmonics, numHarmonics);
+    if (numHarmonics == this->numHarmonics)
+        return;
 
-    for (int h = 0; h < numHarmonics; h++)
+    // harmonics past the new count fade out on the next block
+    this->numHarmonics = numHarmonics;
+    numAudible = -1;                // setAngleChange() recomputes the average gain
+    setAngleChange();
+}
+
+template <typename SampleType>
+void SynthVoice<SampleType>::renderBlock(float* out, int numSamples)
+{
+    renderBlock(out, numSamples, numSamples);
+}
+
+template <typename SampleType>
+void SynthVoice<SampleType>::renderBlock(float* out, int numSamples, int rampSamples)
+{
+    // The host may send more samples than announced in prepareToPlay, so render in chunks
+    int start = 0;
+    while (start < numSamples)
+    {
+        int chunkSize = jmin(numSamples - start, voiceBufferSize);
+        renderChunk(out + start, chunkSize, jmax(chunkSize, rampSamples - start));
+        start += chunkSize;
+    }
+}
+
+template <typename SampleType>
+void SynthVoice<SampleType>::renderChunk(float* out, int numSamples, int rampSamples)
+{
+    fill(voiceBuffer, voiceBuffer + numSamples, 0.f);
+
+    if (morphChanged)
+    {
+        morphChanged = false;
+        spectrumChanged(false);
+    }
+
+    if (tracks != nullptr)
+        applyTracks(numSamples);
+    else if (envelopes != nullptr)
+        applyEnvelopes(numSamples);
+
+    if (engine == wavetableEngine && wavetable != nullptr && canUseWavetable())
+    {
+        renderWavetable(numSamples, rampSamples);
+    }
+    else if (engine == inverseFFTEngine)
+    {
+        spectral.render(voiceBuffer, numSamples);
+    }
+    else
+    {
+        if (playingFromTable)
+        {
+            // table is being rebuilt, continue additively from the same phase
+            for (int i = 0; i < numActive; i++)
+                oscillators.setPhase(i, getPartialRatio(activeHarmonics[i]) * tablePhase);
+            playingFromTable = false;
+        }
+
+        // All harmonics at once, several per instruction. Envelopes and
+        // tracks set the gains for the end of this chunk, they ramp over it.
+        int gainRamp = tracks != nullptr || envelopes != nullptr ? numSamples : rampSamples;
+        oscillators.render(voiceBuffer, numSamples, gainRamp, rampSamples);
+
+        if (partialsFading)
+            updateActivePartials();     // faded out harmonics can be dropped now
+    }
+
+    // The envelope is rendered on its own, one step per sample whatever the
+    // number of harmonics, and applied to the sum with two vector operations
+    for (int n = 0; n < numSamples; n++)
+        envelopeBuffer[n] = adsr.getNextSample();
+    envelopeLevel = envelopeBuffer[numSamples - 1];
+
+    // a morph changes the normalisation every block, ramp it so it doesn't step
+    float gain = (float)averagedGain * velocity;
+    if (gain != outputGain)
+    {
+        float step = (gain - outputGain) / rampSamples;
+        for (int n = 0; n < numSamples; n++)
+            envelopeBuffer[n] *= outputGain + step * (n + 1);
+        outputGain = rampSamples > numSamples ? outputGain + step * numSamples : gain;
+        gain = 1.f;
+    }
+
+    FloatVectorOperations::multiply(voiceBuffer, envelopeBuffer, numSamples);
+    FloatVectorOperations::addWithMultiply(out, voiceBuffer, gain, numSamples);
+}
+
+template <typename SampleType>
+void SynthVoice<SampleType>::applyEnvelopes(int numSamples)
+{
+    // The envelopes move once per block, the oscillators ramp each gain to
+    // its new value over the block inside the SIMD partial loop
+    partialEnvelopes.advance(*envelopes, Fs, numHarmonics, numSamples);
+
+    if (engine == inverseFFTEngine)
+    {
+        for (int h = 0; h < numAudible; h++)
+            spectral.setGain(h, (float)getPartialGain(h));
+    }
+    else
+    {
+        for (int i = 0; i < numActive; i++)
+            oscillators.setGain(i, getPartialGain(activeHarmonics[i]));
+    }
+}
+
+template <typename SampleType>
+void SynthVoice<SampleType>::applyTracks(int numSamples)
+{
+    // One frame per block, like the envelopes: the oscillators ramp to the
+    // gains at the end of the block, the frequencies change at its start
+    trackTime += numSamples / Fs;
+    readTracks(trackTime);
+
+    if (engine == inverseFFTEngine)
+    {
+        for (int h = 0; h < numAudible; h++)
+        {
+            spectral.setIncrement(h, (float)(baseIncrement * getPartialRatio(h)));
+            spectral.setGain(h, (float)getPartialGain(h));
+        }
+    }
+    else
     {
-        if (f0 * (h + 1) < nyquist) // filter out harmonics above nyquist
+        for (int i = 0; i < numActive; i++)
         {
-            out = out + adsr.getNextSample() * gainVector[h] * sin(currentAngle[h]);
+            int h = activeHarmonics[i];
+            oscillators.setIncrement(i, (SampleType)(baseIncrement * getPartialRatio(h)));
+            oscillators.setGain(i, getPartialGain(h));
         }
-        currentAngle[h] += angleChange[h];
+    }
+}
 
-        if (currentAngle[h] > 2.f * double_Pi)
+template <typename SampleType>
+void SynthVoice<SampleType>::readTracks(double time)
+{
+    // The frames are read straight from the mapped file, two rows per
+    // partial array, and interpolated into this voice's own copy
+    int count = jmin(maxHarmonics, tracks->getNumPartials());
+    double position = time * tracks->getFrameRate();
+    int frame = (int)position;
+
+    if (frame + 1 < tracks->getNumFrames())
+    {
+        float fraction = (float)(position - frame);
+        const float* ratios = tracks->getRatios(frame);
+        const float* nextRatios = tracks->getRatios(frame + 1);
+        const float* gains = tracks->getGains(frame);
+        const float* nextGains = tracks->getGains(frame + 1);
+
+        for (int h = 0; h < count; h++)
         {
-            currentAngle[h] -= 2.f * double_Pi;
+            trackRatios[h] = ratios[h] + fraction * (nextRatios[h] - ratios[h]);
+            trackGains[h] = gains[h] + fraction * (nextGains[h] - gains[h]);
         }
     }
-    return out * averagedGain;
+    else
+    {
+        // past the end of the recording everything is silent
+        const float* ratios = tracks->getRatios(tracks->getNumFrames() - 1);
+        for (int h = 0; h < count; h++)
+        {
+            trackRatios[h] = ratios[h];
+            trackGains[h] = 0.f;
+        }
+    }
+}
+
+template <typename SampleType>
+double SynthVoice<SampleType>::getMorphedGain(int harmonic)
+{
+    double gain = tracks != nullptr ? trackGains[harmonic] : spectrum->getGain(harmonic);
+    if (morphTarget != nullptr)
+        gain += morphAmount * (morphTarget->getGain(harmonic) - gain);
+    return gain;
+}
+
+template <typename SampleType>
+double SynthVoice<SampleType>::getPartialRatio(int harmonic)
+{
+    double ratio = tracks != nullptr ? trackRatios[harmonic] : spectrum->getRatio(harmonic);
+    if (morphTarget != nullptr)
+        ratio += morphAmount * (morphTarget->getRatio(harmonic) - ratio);
+    return ratio;
+}
+
+template <typename SampleType>
+SampleType SynthVoice<SampleType>::getPartialGain(int harmonic)
+{
+    if (harmonic >= numAudible)
+        return 0;
+
+    // tracks aren't sorted by frequency, each one is checked on its own
+    if (tracks != nullptr && baseIncrement * getPartialRatio(harmonic) >= 0.5)
+        return 0;
+
+    double gain = getMorphedGain(harmonic);
+    if (envelopes != nullptr)
+        gain *= partialEnvelopes.getLevels()[harmonic];
+
+    return (SampleType)gain;
+}
+
+template <typename SampleType>
+void SynthVoice<SampleType>::renderWavetable(int numSamples, int rampSamples)
+{
+    if (!playingFromTable)
+    {
+        if (harmonicSlot[0] >= 0)
+            tablePhase = oscillators.getPhase(harmonicSlot[0]);
+        tablePhase -= floor(tablePhase);
+        playingFromTable = true;
+    }
+
+    const float* table = wavetable->getTable(targetTableIncrement * Fs);
+    const double size = WavetableSet::tableSize;
+
+    // glide exponentially to the new pitch over the rest of the block
+    double increment = tableIncrement;
+    double step = pow(targetTableIncrement / tableIncrement, 1.0 / rampSamples);
+
+    double phase = tablePhase;
+    for (int n = 0; n < numSamples; n++)
+    {
+        // linear interpolation, the table has one extra sample at the end
+        double position = phase * size;
+        int index = (int)position;
+        float fraction = (float)(position - index);
+        voiceBuffer[n] += table[index] + fraction * (table[index + 1] - table[index]);
+
+        phase += increment;
+        phase -= (int)phase;
+        increment *= step;
+    }
+    tablePhase = phase;
+    tableIncrement = rampSamples > numSamples ? increment : targetTableIncrement;
+}
+
+template <typename SampleType>
+void SynthVoice<SampleType>::setSpectrum(const Spectrum* spectrum)
+{
+    spectrum = spectrum != nullptr ? spectrum : &sineSpectrum;
+    bool sameSpectrum = spectrum == this->spectrum;
+
+    this->spectrum = spectrum;
+    envelopes = spectrum->getEnvelopes();
+
+    if (spectrum->getTracks() != tracks)
+    {
+        // partials past the file's stay silent
+        tracks = spectrum->getTracks();
+        fill(trackRatios, trackRatios + maxHarmonics, 0.f);
+        fill(trackGains, trackGains + maxHarmonics, 0.f);
+        if (tracks != nullptr)
+            readTracks(trackTime);
+    }
+
+    spectrumChanged(sameSpectrum);
 }
 
-void SynthVoice::setHarmonicGain(vector<double>gainVector)
+template <typename SampleType>
+void SynthVoice<SampleType>::setMorph(const Spectrum* target, float amount)
 {
-    this->gainVector = gainVector;
+    amount = jlimit(0.f, 1.f, amount);
+    if (target == morphTarget && amount == morphAmount)
+        return;
+
+    morphTarget = target;
+    morphAmount = amount;
+    morphChanged = true;
+}
 
+template <typename SampleType>
+void SynthVoice<SampleType>::spectrumChanged(bool sameRatios)
+{
     computeAverageGain();
+
+    bool wasHarmonic = harmonicRatios;
+    harmonicRatios = hasHarmonicRatios();
+
+    if (sameRatios || (wasHarmonic && harmonicRatios))
+    {
+        updatePartialGains();
+    }
+    else
+    {
+        // new frequencies, so other partials may be audible too
+        partialsF0 = -1.0;
+        setAngleChange();
+    }
 }
 
-void SynthVoice::computeAverageGain()
+template <typename SampleType>
+bool SynthVoice<SampleType>::hasHarmonicRatios()
+{
+    return spectrum->isHarmonic() && (morphTarget == nullptr || morphAmount == 0.f || morphTarget->isHarmonic());
+}
+
+template <typename SampleType>
+bool SynthVoice<SampleType>::canUseWavetable()
+{
+    // the tables hold the spectrum as it is, harmonic and without changes over time
+    return harmonicRatios && envelopes == nullptr && (morphTarget == nullptr || morphAmount == 0.f);
+}
+
+template <typename SampleType>
+void SynthVoice<SampleType>::updatePartialGains()
 {
-    double totalGain = 0.f;
     for (int h = 0; h < numHarmonics; h++)
     {
-        if (f0 * (h + 1) < nyquist) // only count audible frequencies
+        spectral.setGain(h, (float)getPartialGain(h));
+    }
+    spectral.setNumPartials(numAudible);
+
+    updateActivePartials();
+}
+
+template <typename SampleType>
+void SynthVoice<SampleType>::updateActivePartials()
+{
+    bool f0Changed = (f0 != partialsF0);
+    partialsF0 = f0;
+    partialsFading = false;
+
+    // Increments are cached at a pitch ratio of 1, modulation only changes
+    // the ratio the banks multiply them with
+    if (f0Changed)
+    {
+        baseIncrement = f0 / Fs;
+        for (int h = 0; h < maxHarmonics; h++)
+            spectral.setIncrement(h, (float)(baseIncrement * getPartialRatio(h)));
+    }
+
+    // keep harmonics that should sound, or are still fading out
+    int count = 0;
+    for (int h = 0; h < maxHarmonics; h++)
+    {
+        SampleType target = h < numAudible ? (SampleType)getMorphedGain(h) : 0;
+        SampleType current = harmonicSlot[h] >= 0 ? oscillators.getGain(harmonicSlot[h]) : 0;
+        bool track = tracks != nullptr && h < numAudible;   // keeps its slot while its gain comes and goes
+
+        if (track || target != 0.f || current != 0.f)
         {
-            totalGain = totalGain + gainVector[h];
+            activeHarmonics[count] = h;
+            previousSlot[count] = harmonicSlot[h];
+            count++;
+
+            if (target == 0.f && !track)
+                partialsFading = true;
         }
     }
-    averagedGain =  1.f / totalGain;
+
+    // compact the oscillator bank, phases move along with their harmonic
+    oscillators.reorder(previousSlot, count);
+    oscillators.setNumPartials(count);
+    numActive = count;
+
+    fill(harmonicSlot, harmonicSlot + maxHarmonics, -1);
+    for (int i = 0; i < count; i++)
+    {
+        int h = activeHarmonics[i];
+        harmonicSlot[h] = i;
+
+        // speed in cycles per sample
+        if (f0Changed || previousSlot[i] < 0)
+            oscillators.setIncrement(i, (SampleType)(baseIncrement * getPartialRatio(h)));
+
+        oscillators.setGain(i, getPartialGain(h));
+    }
+}
+
+template <typename SampleType>
+void SynthVoice<SampleType>::computeAverageGain()
+{
+    // the tracks are amplitudes of the recording already
+    if (tracks != nullptr)
+    {
+        averagedGain = 1.0;
+        return;
+    }
+
+    // only audible frequencies count, at the pitch they play at
+    int audible = countAudible(pow(2.0, cent / 1200.0));
+
+    // the totals are kept by the spectra, so a morph doesn't sum any gains
+    double total = spectrum->getTotal(audible);
+    if (morphTarget != nullptr)
+        total += morphAmount * (morphTarget->getTotal(audible) - total);
+
+    averagedGain = total > 0.0 ? 1.0 / total : 1.0;
 }
 
-void SynthVoice::setADSRParams(ADSR::Parameters params)
+template <typename SampleType>
+void SynthVoice<SampleType>::setADSRParams(ADSR::Parameters params)
 {
     adsr.setParameters(params);
 }
 
-void SynthVoice::setF0(double f0)
+template <typename SampleType>
+void SynthVoice<SampleType>::setF0(double f0)
 {
     this->f0 = f0; 
     setAngleChange();
+    tableIncrement = targetTableIncrement;  // a new note jumps, only modulation glides
 }
-void SynthVoice::noteOn()
+template <typename SampleType>
+void SynthVoice<SampleType>::noteOn()
 {
     adsr.noteOn();
+    trackTime = 0.0;                // every note plays the tracks from the start
+    if (envelopes != nullptr)
+        partialEnvelopes.noteOn(*envelopes, Fs);
 }
 
-void SynthVoice::noteOff()
+template <typename SampleType>
+void SynthVoice<SampleType>::noteOff()
 {
     adsr.noteOff();
+    if (envelopes != nullptr)
+        partialEnvelopes.noteOff(*envelopes, Fs);
 }
 
-void SynthVoice::setAngleChange()
+template <typename SampleType>
+void SynthVoice<SampleType>::setOscillatorMode(OscillatorMode mode)
 {
-    for (int h = 0; h < numHarmonics; h++)
+    oscillators.setMode(mode);
+}
+
+template <typename SampleType>
+void SynthVoice<SampleType>::setEngine(Engine engine)
+{
+    this->engine = engine;
+}
+
+template <typename SampleType>
+void SynthVoice<SampleType>::setWavetable(const WavetableSet* wavetable)
+{
+    this->wavetable = wavetable;
+}
+
+template <typename SampleType>
+void SynthVoice<SampleType>::setAngleChange()
+{
+    // the pitch ratio from the modulation glides over the next block
+    double pitchRatio = pow(2.0, cent / 1200.0);
+    oscillators.setPitchRatio((SampleType)pitchRatio);
+    spectral.setPitchRatio((float)pitchRatio);
+    targetTableIncrement = f0 * pitchRatio * (1.f / Fs);
+
+    int audible = countAudible(pitchRatio);
+
+    // only rebuild the partial list when something changed, a different
+    // number of audible partials changes the average gain too
+    if (audible != numAudible || f0 != partialsF0)
     {
-        angleChange[h] = 2.f * double_Pi * f0 * (h + 1) * powf(2.f, cent / 1200.0) * (1.f / Fs);
+        if (audible != numAudible)
+        {
+            numAudible = audible;
+            computeAverageGain();
+        }
+        updatePartialGains();
     }
-}
\ No newline at end of file
+}
+
+template <typename SampleType>
+int SynthVoice<SampleType>::countAudible(double pitchRatio)
+{
+    if (tracks != nullptr)
+        return jmin(numHarmonics, tracks->getNumPartials());    // getPartialGain checks those
+
+    // partials are sorted by frequency, so the audible ones are the first few
+    int audible = 0;
+    while (audible < numHarmonics && f0 * pitchRatio * getPartialRatio(audible) < nyquist)
+        audible++;
+    return audible;
+}
+
+template class SynthVoice<float>;
+template class SynthVoice<double>;
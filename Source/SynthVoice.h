@@ -13,8 +13,17 @@
 #include <JuceHeader.h>
 #include <cmath>
 #include <vector>
+#include "OscillatorBank.h"
+#include "SpectralSynth.h"
+#include "Spectrum.h"
+#include "VoiceArena.h"
+#include "WavetableBank.h"
 using namespace std;
 
+// One note of the synth. SampleType is what the partials are computed in:
+// float runs twice as many partials per SIMD instruction, double keeps the
+// phase of long sustained notes exact. Output is always float.
+template <typename SampleType>
 class SynthVoice {
 
 public: 
@@ -23,17 +32,48 @@ public:
     ~SynthVoice();
 
 
-    void setup(double Fs, int numHarmonics);
-    void setHarmonicGain(vector<double>gainVector);
+    // Sized for maxHarmonics, per-sample data is taken from the arena when
+    // given. Set up after copying a voice, copies share the same memory.
+    void setup(double Fs, int maxHarmonics, int maxBlockSize, VoiceArena* arena = nullptr);
+    static size_t getMemorySize(int maxHarmonics, int maxBlockSize);     // taken from the arena
+    void setNumHarmonics(int numHarmonics);     // up to maxHarmonics, doesn't allocate
+    // Gains shared with the other voices, not copied. The caller keeps the
+    // spectrum alive while the voice uses it. nullptr plays a sine. When the
+    // spectrum has partial envelopes, every partial follows its own and the
+    // wavetable engine plays additively instead. A spectrum with partial
+    // tracks is streamed from its file, one frame per block, from note on.
+    void setSpectrum(const Spectrum* spectrum);
+    // Gains and frequency ratios move from the spectrum towards target,
+    // amount 0 - 1. Applied at the start of the next block, the partial
+    // gains ramp there over the block. target has to stay alive like the spectrum.
+    void setMorph(const Spectrum* target, float amount);
     
-    double getNextSample();
+    void renderBlock(float* out, int numSamples);   // adds numSamples of this voice to out
+    // The same for part of a block: gains, pitch and level ramp over
+    // rampSamples, what is left of the block, so a block split at MIDI
+    // events ramps as smoothly as a whole one
+    void renderBlock(float* out, int numSamples, int rampSamples);
 
     void setADSRParams(ADSR::Parameters params);
     void setF0(double f0);
     void noteOn();
     //void noteOn(double f0);
+    void setVelocity(float velocity) { this->velocity = velocity; }     // 0 - 1, scales the whole note
     void noteOff();
     void setAngleChange();          // changing the angular speed
+    void setOscillatorMode(OscillatorMode mode);
+
+    enum Engine
+    {
+        oscillatorEngine = 0,       // time domain oscillator bank
+        inverseFFTEngine,           // spectral frames and overlap-add, for many partials
+        wavetableEngine,            // baked tables of the current spectrum
+        numEngines
+    };
+    void setEngine(Engine engine);
+    void setWavetable(const WavetableSet* wavetable);   // nullptr while it is being rebuilt
+    int getNumActivePartials() { return numActive; }    // rough cost of rendering this voice
+    float getLevel() { return envelopeLevel; }          // envelope at the end of the last block
     
     double cent = 0;                
     double f0 = 220; 
@@ -43,13 +83,63 @@ public:
 private:
 
     void computeAverageGain();      // changing the gain when harmonics are altered
+    void renderChunk(float* out, int numSamples, int rampSamples);
+    void updatePartialGains();      // copy audible gains into the oscillator bank
+    void updateActivePartials();    // rebuild the list of audible, non-zero harmonics
+    void applyEnvelopes(int numSamples);    // partial gains at the end of the next numSamples
+    void applyTracks(int numSamples);       // partial gains and frequencies at the end of the next numSamples
+    void readTracks(double time);
+    void spectrumChanged(bool sameRatios);
+    bool hasHarmonicRatios();
+    bool canUseWavetable();
+    double getMorphedGain(int harmonic);        // between the spectrum and the morph target
+    double getPartialRatio(int harmonic);
+    int countAudible(double pitchRatio);        // partials below nyquist at f0 times pitchRatio
+    SampleType getPartialGain(int harmonic);    // morphed, with the partial envelope, 0 when not audible
+    void renderWavetable(int numSamples, int rampSamples);
    
-    vector<double> gainVector;      // list containing gain for each harmonic
-    vector<double> currentAngle;    // current angle of all harmonics
-    vector<double> angleChange;     // angular speed of all harmonics
+    const Spectrum* spectrum = nullptr;     // gains in use
+    const PartialEnvelopes* envelopes = nullptr;    // the spectrum's, nullptr when partials only follow the ADSR
+    const PartialTrackFile* tracks = nullptr;   // the spectrum's, nullptr when it is static
+    double trackTime = 0.0;         // seconds since note on
+    float* trackRatios = nullptr;   // the tracks at trackTime, between two frames
+    float* trackGains = nullptr;
+    const Spectrum* morphTarget = nullptr;
+    float morphAmount = 0.f;
+    bool morphChanged = false;      // picked up by the next block
+    bool harmonicRatios = true;     // the increments were set for whole number ratios
+    PartialEnvelopeState partialEnvelopes;
+    float* voiceBuffer = nullptr;   // partial sum of one block, before the envelope
+    float* envelopeBuffer = nullptr;    // envelope of one block, one value per sample
+    int voiceBufferSize = 0;
+    vector<float> ownBuffer;        // the buffers and the partial arrays when there is no arena
+
+    OscillatorBank<SampleType> oscillators;     // phase, speed and gain of the active harmonics
+
+    // Only harmonics that are below nyquist and have a gain are rendered.
+    // The list changes with f0, modulation and gains, not per sample.
+    int* activeHarmonics = nullptr;     // harmonic in each oscillator slot
+    int* harmonicSlot = nullptr;        // oscillator slot of each harmonic, -1 if not active
+    int* previousSlot = nullptr;        // scratch while rebuilding the list
+    int numActive = 0;
+    int numAudible = 0;             // harmonics below nyquist at the current pitch
+    double partialsF0 = -1.0;       // f0 the oscillator increments were set for
+    double baseIncrement = 0.0;     // partialsF0 in cycles per sample, partial h runs at its ratio times this
+    bool partialsFading = false;    // a removed harmonic ramps to 0 first, rebuild after the block
+    SpectralSynth spectral;         // the same harmonics, rendered with an inverse FFT
+    Engine engine = oscillatorEngine;
+
+    const WavetableSet* wavetable = nullptr;
+    double tablePhase = 0.0;        // cycles of the fundamental
+    double tableIncrement = 0.0;    // cycles per sample of the fundamental
+    double targetTableIncrement = 0.0;
+    bool playingFromTable = false;
 
     
     ADSR::Parameters adsrParams;    // envelope parameters
+    float envelopeLevel = 0.f;      // last envelope sample
+    float velocity = 1.f;
+    float outputGain = 0.f;         // normalisation times velocity of the last block, ramped from
 
     double Fs = 48000;              // sampling rate
     double nyquist = Fs / 2.f;      // fundam
@@ -57,5 +147,18 @@ private:
 
     
     int numHarmonics;               // number of harmonics
+    int maxHarmonics = 0;           // harmonics the voice was set up for
 
-};
\ No newline at end of file
+};
+
+// Build option: set ADDITIVESYNTH_DOUBLE_PRECISION=1 in the exporter's
+// preprocessor definitions to render the plugin's voices in double
+#ifndef ADDITIVESYNTH_DOUBLE_PRECISION
+ #define ADDITIVESYNTH_DOUBLE_PRECISION 0
+#endif
+
+#if ADDITIVESYNTH_DOUBLE_PRECISION
+typedef SynthVoice<double> Voice;
+#else
+typedef SynthVoice<float> Voice;
+#endif
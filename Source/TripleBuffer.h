@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    TripleBuffer.h
+    Created: 18 Oct 2026 9:21:37am
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+using namespace std;
+
+// Hands the latest version of T from one writer thread to one reader thread
+// without locks or allocations. The writer fills getWriteBuffer() and calls
+// publish(), the reader calls read() whenever it likes and gets the newest
+// published value, or nullptr when nothing changed since the last read.
+// Intermediate versions are skipped, which is what we want for parameters.
+template <typename T>
+class TripleBuffer {
+
+public:
+    T& getWriteBuffer() { return buffers[writeIndex]; }
+
+    void publish()
+    {
+        // hand the written buffer to the middle slot and take the old middle one
+        writeIndex = middle.exchange(writeIndex | newFlag, memory_order_acq_rel) & indexMask;
+    }
+
+    const T* read()
+    {
+        if ((middle.load(memory_order_acquire) & newFlag) == 0)
+            return nullptr;
+
+        readIndex = middle.exchange(readIndex, memory_order_acq_rel) & indexMask;
+        return &buffers[readIndex];
+    }
+
+private:
+    enum { indexMask = 3, newFlag = 4 };
+
+    T buffers[3];
+    atomic<int> middle { 1 };   // index of the middle buffer, plus newFlag when unread
+    int writeIndex = 0;         // writer thread only
+    int readIndex = 2;          // reader thread only
+};
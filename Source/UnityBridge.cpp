@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    UnityBridge.cpp
+    Created: 20 Oct 2026 3:02:51pm
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#include "UnityBridge.h"
+
+namespace UnityBridge
+{
+    static atomic<NoteEventQueue*> instances[maxInstances];
+
+    int addInstance(NoteEventQueue* queue)
+    {
+        for (int i = 0; i < maxInstances; i++)
+        {
+            NoteEventQueue* expected = nullptr;
+            if (instances[i].compare_exchange_strong(expected, queue))
+                return i + 1;
+        }
+        return 0;
+    }
+
+    void removeInstance(int id)
+    {
+        if (id > 0 && id <= maxInstances)
+            instances[id - 1].store(nullptr);
+    }
+
+    static NoteEventQueue* getQueue(int id)
+    {
+        return id > 0 && id <= maxInstances ? instances[id - 1].load(memory_order_acquire) : nullptr;
+    }
+
+    static int push(int id, const NoteEvent& event)
+    {
+        NoteEventQueue* queue = getQueue(id);
+        return queue != nullptr && queue->push(event) ? 1 : 0;
+    }
+}
+
+double AdditiveSynth_getTime(int instance)
+{
+    NoteEventQueue* queue = UnityBridge::getQueue(instance);
+    return queue != nullptr ? queue->getTime() : 0.0;
+}
+
+int AdditiveSynth_noteOn(int instance, double time, int note, float frequency, float velocity)
+{
+    return UnityBridge::push(instance, { time, NoteEvent::noteOn, note, frequency, velocity });
+}
+
+int AdditiveSynth_noteOff(int instance, double time, int note)
+{
+    return UnityBridge::push(instance, { time, NoteEvent::noteOff, note, 0.f, 0.f });
+}
+
+int AdditiveSynth_setParameter(int instance, double time, int parameterIndex, float value)
+{
+    return UnityBridge::push(instance, { time, NoteEvent::parameterChange, parameterIndex, value, 0.f });
+}
@@ -0,0 +1,41 @@
+/*
+  ==============================================================================
+
+    UnityBridge.h
+    Created: 20 Oct 2026 3:02:51pm
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "NoteEventQueue.h"
+using namespace std;
+
+// Plain C functions a Unity script calls through DllImport to play notes.
+// Every plugin instance registers its event queue and shows the id it got in
+// its read-only "instanceId" parameter, which the script passes back here.
+// Times are in seconds on the instance's own clock: AdditiveSynth_getTime()
+// plus a delay schedules ahead, 0 plays as soon as possible. The functions
+// return 1 when the event was queued and 0 when the id is unknown or the
+// queue is full. Instances must not be destroyed while a call is running.
+namespace UnityBridge
+{
+    static constexpr int maxInstances = 64;
+
+    int addInstance(NoteEventQueue* queue);     // id from 1, 0 when there's no room
+    void removeInstance(int id);
+}
+
+#if JUCE_WINDOWS
+ #define ADDITIVESYNTH_EXPORT extern "C" __declspec(dllexport)
+#else
+ #define ADDITIVESYNTH_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+ADDITIVESYNTH_EXPORT double AdditiveSynth_getTime(int instance);
+ADDITIVESYNTH_EXPORT int AdditiveSynth_noteOn(int instance, double time, int note, float frequency, float velocity);
+ADDITIVESYNTH_EXPORT int AdditiveSynth_noteOff(int instance, double time, int note);
+ADDITIVESYNTH_EXPORT int AdditiveSynth_setParameter(int instance, double time, int parameterIndex, float value);   // value 0 - 1
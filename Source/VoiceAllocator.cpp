@@ -0,0 +1,207 @@
+/*
+  ==============================================================================
+
+    VoiceAllocator.cpp
+    Created: 18 Oct 2026 4:12:51pm
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#include "VoiceAllocator.h"
+
+void VoiceAllocator::VoiceList::prepare(int numVoices)
+{
+    voices.assign(numVoices, 0);
+    position.assign(numVoices, -1);
+    size = 0;
+}
+
+void VoiceAllocator::VoiceList::add(int voice)
+{
+    if (contains(voice))
+        return;
+
+    position[voice] = size;
+    voices[size++] = voice;
+}
+
+void VoiceAllocator::VoiceList::remove(int voice)
+{
+    if (!contains(voice))
+        return;
+
+    // move the last voice into the gap
+    int last = voices[--size];
+    voices[position[voice]] = last;
+    position[last] = position[voice];
+    position[voice] = -1;
+}
+
+VoiceAllocator::VoiceAllocator()
+{
+}
+
+VoiceAllocator::~VoiceAllocator()
+{
+}
+
+void VoiceAllocator::prepare(Voice* voices, int maxVoices)
+{
+    this->voices = voices;
+    this->maxVoices = maxVoices;
+    numVoices = maxVoices;
+
+    freeVoices.prepare(maxVoices);
+    active.prepare(maxVoices);
+    voiceNote.assign(maxVoices, -1);
+    held.assign(maxVoices, false);
+    startTime.assign(maxVoices, 0);
+
+    reset();
+}
+
+void VoiceAllocator::reset()
+{
+    active.size = 0;
+    for (int v = 0; v < maxVoices; v++)
+    {
+        active.position[v] = -1;
+        voiceNote[v] = -1;
+        held[v] = false;
+    }
+
+    for (int n = 0; n < numNotes; n++)
+        noteVoice[n] = -1;
+
+    setNumVoices(numVoices);
+}
+
+void VoiceAllocator::setNumVoices(int numVoices)
+{
+    this->numVoices = jlimit(0, maxVoices, numVoices);
+
+    // sounding voices past the count go back to the free list when they finish
+    freeVoices.size = 0;
+    for (int v = maxVoices; --v >= 0;)
+    {
+        freeVoices.position[v] = -1;
+        if (v < this->numVoices && !active.contains(v))
+            freeVoices.add(v);      // voice 0 ends up on top
+    }
+}
+
+int VoiceAllocator::noteOn(int note, int& releasedVoice)
+{
+    releasedVoice = -1;
+    if (numVoices == 0)
+        return -1;
+
+    int voice = -1;
+    if (note >= 0 && note < numNotes && noteVoice[note] >= 0)
+    {
+        if (policy == retriggerSameNote)
+            voice = noteVoice[note];
+        else if (held[noteVoice[note]])
+        {
+            // The note map only follows the new voice, so the next note-off
+            // would never reach the old one and it would hold until stolen
+            releasedVoice = noteVoice[note];
+            held[releasedVoice] = false;
+        }
+    }
+
+    if (voice < 0 && freeVoices.size > 0)
+        voice = freeVoices.voices[freeVoices.size - 1];
+
+    if (voice < 0)
+        voice = findVoiceToSteal();
+
+    if (voice == releasedVoice)
+        releasedVoice = -1;         // stolen right away, it starts again anyway
+
+    startVoice(voice, note);
+    return voice;
+}
+
+int VoiceAllocator::noteOff(int note)
+{
+    if (note < 0 || note >= numNotes)
+        return -1;
+
+    int voice = noteVoice[note];
+    if (voice < 0 || !held[voice])
+        return -1;
+
+    held[voice] = false;
+    return voice;
+}
+
+void VoiceAllocator::startVoice(int voice, int note)
+{
+    // a stolen voice stops answering to its old note
+    int oldNote = voiceNote[voice];
+    if (oldNote >= 0 && noteVoice[oldNote] == voice)
+        noteVoice[oldNote] = -1;
+
+    freeVoices.remove(voice);
+    active.add(voice);
+
+    voiceNote[voice] = note;
+    if (note >= 0 && note < numNotes)
+        noteVoice[note] = voice;
+    held[voice] = true;
+    startTime[voice] = ++clock;
+}
+
+void VoiceAllocator::stopVoice(int voice)
+{
+    held[voice] = false;
+}
+
+void VoiceAllocator::voiceFinished(int voice)
+{
+    int note = voiceNote[voice];
+    if (note >= 0 && noteVoice[note] == voice)
+        noteVoice[note] = -1;
+
+    voiceNote[voice] = -1;
+    held[voice] = false;
+    active.remove(voice);
+    if (voice < numVoices)
+        freeVoices.add(voice);
+}
+
+int VoiceAllocator::findVoiceToSteal()
+{
+    // released voices go first, they are already fading out
+    int best = -1;
+    bool bestHeld = true;
+    float bestLevel = 0.f;
+
+    for (int i = 0; i < active.size; i++)
+    {
+        int voice = active.voices[i];
+        if (voice >= numVoices)
+            continue;               // already on its way out
+
+        float level = voices[voice].getLevel();
+
+        bool better;
+        if (best < 0 || held[voice] != bestHeld)
+            better = best < 0 || !held[voice];
+        else if (policy == stealQuietest)
+            better = level < bestLevel;
+        else
+            better = startTime[voice] < startTime[best];
+
+        if (better)
+        {
+            best = voice;
+            bestHeld = held[voice];
+            bestLevel = level;
+        }
+    }
+
+    return best;
+}
@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    VoiceAllocator.h
+    Created: 18 Oct 2026 4:12:51pm
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+#include "SynthVoice.h"
+using namespace std;
+
+// Decides which voice plays a note. Free and sounding voices are kept in two
+// lists with O(1) insert and remove, and every MIDI note maps to the voice
+// playing it, so nothing scans all voices. When no voice is free one is
+// stolen according to the policy. Audio thread only, never allocates after
+// prepare().
+class VoiceAllocator {
+
+public:
+    VoiceAllocator();
+    ~VoiceAllocator();
+
+    enum Policy
+    {
+        stealOldest = 0,            // voice that started first
+        stealQuietest,              // lowest envelope level
+        retriggerSameNote,          // a note that is still sounding restarts its voice, else oldest
+        numPolicies
+    };
+
+    static constexpr int numNotes = 128;
+
+    void prepare(Voice* voices, int maxVoices);
+    void setNumVoices(int numVoices);           // only voices below this are started
+    int getNumVoices() { return numVoices; }
+    void setPolicy(Policy policy) { this->policy = policy; }
+    void reset();                               // all voices free
+
+    // Voice that should start the note. A voice still holding the same note
+    // is released and returned in releasedVoice, else -1; call noteOff() on it.
+    int noteOn(int note, int& releasedVoice);
+    int noteOff(int note);                      // voice holding the note, -1 if none
+
+    // Voices addressed directly, as Unity does
+    void startVoice(int voice, int note = -1);
+    void stopVoice(int voice);
+
+    // Call after rendering, for sounding voices whose envelope has ended
+    void voiceFinished(int voice);
+
+    int getNumActive() { return active.size; }
+    const int* getActiveVoices() { return active.voices.data(); }
+    bool isActive(int voice) { return active.contains(voice); }
+
+private:
+    // Set of voice numbers with O(1) add, remove and lookup
+    struct VoiceList
+    {
+        void prepare(int numVoices);
+        void add(int voice);
+        void remove(int voice);
+        bool contains(int voice) { return position[voice] >= 0; }
+
+        vector<int> voices;         // first size entries are in the list
+        vector<int> position;       // index in voices, -1 if not in the list
+        int size = 0;
+    };
+
+    int findVoiceToSteal();
+
+    Voice* voices = nullptr;
+    int maxVoices = 0;
+    int numVoices = 0;
+    Policy policy = stealOldest;
+
+    VoiceList freeVoices;
+    VoiceList active;
+
+    int noteVoice[numNotes];        // voice that last started each note, -1 if none
+    vector<int> voiceNote;          // note of each voice, -1 if none
+    vector<bool> held;              // note is down, noteOff() still expected
+    vector<int64> startTime;        // order in which voices were started
+    int64 clock = 0;
+};
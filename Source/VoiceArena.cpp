@@ -0,0 +1,40 @@
+/*
+  ==============================================================================
+
+    VoiceArena.cpp
+    Created: 18 Oct 2026 6:30:12pm
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#include "VoiceArena.h"
+
+VoiceArena::VoiceArena()
+{
+}
+
+VoiceArena::~VoiceArena()
+{
+}
+
+void VoiceArena::allocate(size_t numBytes)
+{
+    numBytes = roundUp(numBytes);
+    if (numBytes > size)
+    {
+        // extra cache line to align the start
+        memory.allocate(numBytes + alignment, false);
+        base = reinterpret_cast<char*>(roundUp(reinterpret_cast<uintptr_t>(memory.get())));
+        size = numBytes;
+    }
+
+    reset();
+}
+
+void VoiceArena::reset()
+{
+    if (base != nullptr)
+        zeromem(base, size);
+    used = 0;
+}
@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    VoiceArena.h
+    Created: 18 Oct 2026 6:30:12pm
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+using namespace std;
+
+// One block of memory for the per-sample data of all voices. Everything is
+// handed out in cache line aligned pieces from the start of the block, so
+// voices sit next to each other and never share a cache line. allocate() is
+// the only allocation; take() and reset() never touch the heap.
+//
+// take() returns nullptr when the block is full, callers that need more than
+// one piece check hasRoom() for all of them first and use their own memory
+// when it is false.
+class VoiceArena {
+
+public:
+    VoiceArena();
+    ~VoiceArena();
+
+    static constexpr size_t alignment = 64;     // one cache line
+
+    static size_t roundUp(size_t numBytes) { return (numBytes + alignment - 1) & ~(alignment - 1); }
+
+    // Message thread. Keeps the current block when it is big enough already.
+    void allocate(size_t numBytes);
+    void reset();                               // hand out from the start again, zeroed
+
+    template <typename T>
+    T* take(int count)
+    {
+        size_t numBytes = roundUp(count * sizeof(T));
+        if (!hasRoom(numBytes))
+        {
+            jassertfalse;                       // allocate() was asked for too little
+            return nullptr;
+        }
+
+        T* piece = reinterpret_cast<T*>(base + used);
+        used += numBytes;
+        return piece;
+    }
+
+    bool hasRoom(size_t numBytes) { return used + numBytes <= size; }
+    size_t getSize() { return size; }
+    size_t getUsed() { return used; }
+
+private:
+    HeapBlock<char> memory;
+    char* base = nullptr;           // first aligned byte of memory
+    size_t size = 0;
+    size_t used = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(VoiceArena)
+};
@@ -0,0 +1,242 @@
+/*
+  ==============================================================================
+
+    VoiceRenderPool.cpp
+    Created: 18 Oct 2026 2:05:44pm
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#include "VoiceRenderPool.h"
+
+// The threads and the current round, one per process
+class VoiceRenderPool::Workers {
+
+public:
+    ~Workers() { stop(); }
+
+    void addUser();
+    void removeUser();
+    int getNumThreads() { return numThreads; }
+
+    // Claims and renders one voice of the round, false when none are left.
+    // bufferRound is nullptr for the audio thread, which renders into out.
+    bool renderNextVoice(uint64 round, float* buffer, atomic<uint64>* bufferRound);
+
+    atomic<bool> inUse { false };       // an instance is rendering a block with the workers
+
+    // Current block, written before jobCounter is released
+    Voice** jobVoices = nullptr;
+    int jobSamples = 0;
+    int jobRampSamples = 0;
+
+    // Round number in the high 32 bits, the round's number of voices in the
+    // next 16 and the next voice in the low 16. The count is part of the same
+    // word, so a worker still holding a counter from the last round can
+    // neither pass the bounds check with the new count nor swap its stale
+    // value in, and never takes a voice from the next block.
+    atomic<uint64> jobCounter { 0 };
+    atomic<int> finishedJobs { 0 };
+    uint32 round = 0;
+
+    static constexpr int maxJobs = 0xffff;
+
+    vector<unique_ptr<Worker>> threads;
+
+private:
+    void stop();
+
+    CriticalSection lock;               // prepare and release of all instances
+    int numUsers = 0;
+    atomic<int> numThreads { 0 };       // read by the audio threads
+};
+
+class VoiceRenderPool::Worker : public Thread {
+
+public:
+    Worker(Workers& pool, int index)
+        : Thread("Voice renderer " + String(index)), pool(pool)
+    {
+        buffer.assign(blockSize, 0.f);
+    }
+
+    void run() override
+    {
+        // the audio thread's flags don't carry over to this one
+        ScopedNoDenormals noDenormals;
+
+        uint64 lastRound = pool.jobCounter.load() >> 32;
+        int idleCount = 0;
+
+        while (!threadShouldExit())
+        {
+            uint64 round = pool.jobCounter.load() >> 32;
+            if (round == lastRound)
+            {
+                // Blocks come in quickly while playing, so spin for a while
+                // before napping. Naps get longer once nothing has been
+                // rendered for a while, so an idle plugin costs next to nothing.
+                idleCount = jmin(idleCount + 1, spinCount + napCount);
+                if (idleCount < spinCount)
+                    Thread::yield();
+                else
+                    Thread::sleep(idleCount < spinCount + napCount ? 1 : 20);
+                continue;
+            }
+
+            lastRound = round;
+            idleCount = 0;
+            while (pool.renderNextVoice(round, buffer.data(), &bufferRound))
+            {
+            }
+        }
+    }
+
+    vector<float> buffer;               // this thread's sum of voices for one block
+    atomic<uint64> bufferRound { 0 };   // round the buffer holds voices for
+
+private:
+    static constexpr int spinCount = 2000;
+    static constexpr int napCount = 1000;      // short naps before the long ones
+
+    Workers& pool;
+};
+
+void VoiceRenderPool::Workers::addUser()
+{
+    const ScopedLock sl(lock);
+    if (numUsers++ > 0)
+        return;
+
+    // leave one core for the audio thread itself, which renders voices too
+    int count = jlimit(0, maxWorkers, SystemStats::getNumCpus() - 1);
+    for (int i = 0; i < count; i++)
+    {
+        threads.push_back(make_unique<Worker>(*this, i));
+
+        // The audio thread waits for voices a worker has started, so a
+        // worker preempted by a normal thread would hold it up
+        if (!threads.back()->startRealtimeThread(Thread::RealtimeOptions()))
+            threads.back()->startThread(Thread::Priority::highest);
+    }
+    numThreads = count;
+}
+
+void VoiceRenderPool::Workers::removeUser()
+{
+    const ScopedLock sl(lock);
+    if (--numUsers == 0)
+        stop();
+}
+
+void VoiceRenderPool::Workers::stop()
+{
+    numThreads = 0;
+
+    for (auto& thread : threads)
+        thread->signalThreadShouldExit();
+
+    for (auto& thread : threads)
+        thread->stopThread(1000);
+
+    threads.clear();
+}
+
+VoiceRenderPool::VoiceRenderPool()
+{
+}
+
+VoiceRenderPool::~VoiceRenderPool()
+{
+    release();
+}
+
+void VoiceRenderPool::prepare()
+{
+    if (!prepared)
+        workers->addUser();
+    prepared = true;
+}
+
+void VoiceRenderPool::release()
+{
+    if (prepared)
+        workers->removeUser();
+    prepared = false;
+}
+
+int VoiceRenderPool::getNumWorkers()
+{
+    return prepared ? workers->getNumThreads() : 0;
+}
+
+void VoiceRenderPool::render(Voice** voices, int numVoices, float* out, int numSamples, int rampSamples)
+{
+    Workers& pool = *workers;
+    jassert(numVoices <= Workers::maxJobs);
+
+    // another instance may have the workers for this block
+    if (getNumWorkers() == 0 || numVoices < 2 || pool.inUse.exchange(true, memory_order_acquire))
+    {
+        for (int i = 0; i < numVoices; i++)
+            voices[i]->renderBlock(out, numSamples, rampSamples);
+        return;
+    }
+
+    for (int start = 0; start < numSamples; start += blockSize)
+    {
+        pool.jobVoices = voices;
+        pool.jobSamples = jmin(blockSize, numSamples - start);
+        pool.jobRampSamples = jmax(pool.jobSamples, rampSamples - start);
+        pool.finishedJobs.store(0);
+
+        // start the round, workers pick it up when they next look
+        uint32 round = ++pool.round;
+        pool.jobCounter.store(((uint64)round << 32) | ((uint64)numVoices << 16), memory_order_release);
+
+        // the audio thread takes voices too, straight into the output
+        while (pool.renderNextVoice(round, out + start, nullptr))
+        {
+        }
+
+        // Only voices a worker already started are left. Spin for those,
+        // then yield, in case the worker was preempted on this core.
+        for (int spin = 0; pool.finishedJobs.load(memory_order_acquire) < numVoices; spin++)
+        {
+            if (spin >= waitSpinCount)
+                Thread::yield();
+        }
+
+        for (auto& worker : pool.threads)
+        {
+            if (worker->bufferRound.load(memory_order_acquire) == round)
+                FloatVectorOperations::add(out + start, worker->buffer.data(), pool.jobSamples);
+        }
+    }
+
+    pool.inUse.store(false, memory_order_release);
+}
+
+bool VoiceRenderPool::Workers::renderNextVoice(uint64 round, float* buffer, atomic<uint64>* bufferRound)
+{
+    uint64 counter = jobCounter.load(memory_order_acquire);
+    do
+    {
+        if ((counter >> 32) != round || (int)(counter & maxJobs) >= (int)((counter >> 16) & maxJobs))
+            return false;
+    } while (!jobCounter.compare_exchange_weak(counter, counter + 1, memory_order_acq_rel));
+
+    int index = (int)(counter & maxJobs);
+
+    // first voice of this round for a worker: start from silence
+    if (bufferRound != nullptr && bufferRound->load(memory_order_relaxed) != round)
+    {
+        FloatVectorOperations::clear(buffer, jobSamples);
+        bufferRound->store(round, memory_order_release);
+    }
+
+    jobVoices[index]->renderBlock(buffer, jobSamples, jobRampSamples);
+    finishedJobs.fetch_add(1, memory_order_release);
+    return true;
+}
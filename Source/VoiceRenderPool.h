@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    VoiceRenderPool.h
+    Created: 18 Oct 2026 2:05:44pm
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "SynthVoice.h"
+using namespace std;
+
+// Renders voices on a set of worker threads plus the audio thread.
+// Voices are handed out with one atomic counter, every thread sums into its
+// own buffer and the audio thread adds those up at the end. The audio thread
+// never waits for a worker to wake up: it takes voices itself and only waits
+// for voices a worker has already started. It doesn't wake workers either,
+// signalling a thread takes a lock; idle workers poll for the next round.
+//
+// The workers are shared by every plugin instance in the process, at most
+// one per core but one and never more than maxWorkers, and run while at
+// least one instance is prepared. One instance uses them at a time, another
+// one that finds them busy renders its voices on its own audio thread.
+class VoiceRenderPool {
+
+public:
+    VoiceRenderPool();
+    ~VoiceRenderPool();
+
+    // Message thread. Joins the shared workers, starting them if this is the
+    // first prepared pool.
+    void prepare();
+    void release();
+
+    int getNumWorkers();
+
+    // Audio thread. Adds voices[0..numVoices) to out, ramping over
+    // rampSamples like Voice::renderBlock().
+    void render(Voice** voices, int numVoices, float* out, int numSamples, int rampSamples);
+
+    static constexpr int maxWorkers = 8;
+    static constexpr int blockSize = 512;       // worker buffers, longer blocks are rendered in parts
+
+private:
+    class Worker;
+    class Workers;
+
+    SharedResourcePointer<Workers> workers;
+    bool prepared = false;
+
+    static constexpr int waitSpinCount = 4000;  // then the audio thread yields while it waits
+
+    JUCE_DECLARE_NON_COPYABLE(VoiceRenderPool)
+};
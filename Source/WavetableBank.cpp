@@ -0,0 +1,158 @@
+/*
+  ==============================================================================
+
+    WavetableBank.cpp
+    Created: 17 Oct 2026 3:40:08pm
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#include "WavetableBank.h"
+
+static_assert(1 << 11 == WavetableSet::tableSize, "FFT order has to match the table size");
+
+const float* WavetableSet::getTable(double frequency) const
+{
+    int octave = (int)floor(log2(jmax(frequency, lowestFrequency) / lowestFrequency));
+    return samples[jlimit(0, numOctaves - 1, octave)];
+}
+
+WavetableBank::WavetableBank() : Thread("Wavetable baker")
+{
+    for (auto& gain : pendingGains)
+        gain.store(0.f, memory_order_relaxed);
+
+    fftBuffer.assign(2 * WavetableSet::tableSize, 0.f);
+    startThread();
+}
+
+WavetableBank::~WavetableBank()
+{
+    stopThread(1000);
+
+    delete currentSet.load();
+    for (auto& retired : retiredSets)
+        delete retired.set;
+}
+
+void WavetableBank::prepare(double sampleRate)
+{
+    this->sampleRate.store(sampleRate);
+}
+
+void WavetableBank::requestBake(const vector<double>& gainVector)
+{
+    requestBake(gainVector.data(), (int)gainVector.size());
+}
+
+void WavetableBank::requestBake(const double* gains, int numHarmonics)
+{
+    numHarmonics = jmin(numHarmonics, (int)maxHarmonics);
+
+    pendingSequence.fetch_add(1, memory_order_acq_rel);
+    for (int h = 0; h < numHarmonics; h++)
+        pendingGains[h].store((float)gains[h], memory_order_relaxed);
+    pendingNumHarmonics.store(numHarmonics, memory_order_relaxed);
+    pendingSequence.fetch_add(1, memory_order_release);
+
+    requestedVersion.fetch_add(1, memory_order_release);       // the baker polls this
+}
+
+const WavetableSet* WavetableBank::getCurrentSet()
+{
+    WavetableSet* set = currentSet.load(memory_order_acquire);
+    audioBlockCount.fetch_add(1, memory_order_release);
+
+    if (set == nullptr || set->version != requestedVersion.load(memory_order_acquire)
+        || set->sampleRate != sampleRate.load(memory_order_relaxed))
+        return nullptr;
+
+    return set;
+}
+
+void WavetableBank::run()
+{
+    int bakedVersion = 0;
+    double bakedSampleRate = 0.0;
+
+    while (!threadShouldExit())
+    {
+        int version = requestedVersion.load(memory_order_acquire);
+        if (version != bakedVersion || sampleRate.load() != bakedSampleRate)
+        {
+            bakedVersion = version;
+            bakedSampleRate = sampleRate.load();
+            bake();
+        }
+
+        freeRetiredSets();
+
+        // never notified, so the audio thread doesn't take a lock to request a bake
+        wait(pollInterval);
+    }
+}
+
+void WavetableBank::bake()
+{
+    // copy the latest request, retrying when it changed while reading
+    vector<float> gains(maxHarmonics, 0.f);
+    int numHarmonics;
+    int version;
+    int sequence;
+    do
+    {
+        sequence = pendingSequence.load(memory_order_acquire);
+        version = requestedVersion.load(memory_order_acquire);
+        numHarmonics = pendingNumHarmonics.load(memory_order_relaxed);
+        for (int h = 0; h < numHarmonics; h++)
+            gains[h] = pendingGains[h].load(memory_order_relaxed);
+
+        // keeps the relaxed loads above before the second look at the sequence
+        atomic_thread_fence(memory_order_acquire);
+    } while ((sequence & 1) != 0 || sequence != pendingSequence.load(memory_order_relaxed));
+
+    auto* set = new WavetableSet();
+    set->version = version;
+    set->sampleRate = sampleRate.load();
+
+    const int size = WavetableSet::tableSize;
+    for (int octave = 0; octave < WavetableSet::numOctaves; octave++)
+    {
+        // highest fundamental that will play from this table
+        double highestFrequency = WavetableSet::lowestFrequency * pow(2.0, octave + 1);
+
+        // one cycle of g * sin(2 pi (h + 1) n / size) is bin h + 1 with value -j g size / 2
+        fill(fftBuffer.begin(), fftBuffer.end(), 0.f);
+        for (int h = 0; h < numHarmonics && h + 1 < size / 2; h++)
+        {
+            if (highestFrequency * (h + 1) < set->sampleRate / 2.0)
+                fftBuffer[2 * (h + 1) + 1] = -0.5f * gains[h] * size;
+        }
+        fft.performRealOnlyInverseTransform(fftBuffer.data());
+
+        copy(fftBuffer.begin(), fftBuffer.begin() + size, set->samples[octave]);
+        set->samples[octave][size] = set->samples[octave][0];
+    }
+
+    WavetableSet* old = currentSet.exchange(set, memory_order_acq_rel);
+    if (old != nullptr)
+        retiredSets.push_back({ old, audioBlockCount.load(memory_order_acquire) });
+}
+
+void WavetableBank::freeRetiredSets()
+{
+    // The audio thread reads the pointer before counting the block. Two more
+    // blocks after the swap mean it has loaded the new set and finished any
+    // block that still used the old one.
+    int64 blockCount = audioBlockCount.load(memory_order_acquire);
+
+    for (int i = (int)retiredSets.size(); --i >= 0;)
+    {
+        if (blockCount >= retiredSets[i].blockCount + 2)
+        {
+            delete retiredSets[i].set;
+            retiredSets.erase(retiredSets.begin() + i);
+        }
+    }
+}
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    WavetableBank.h
+    Created: 17 Oct 2026 3:40:08pm
+    Author:  Helmer Nuijens
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <vector>
+using namespace std;
+
+// One cycle of the current spectrum for every octave. Each table only holds
+// the harmonics that stay below nyquist for the highest note of its octave,
+// so playback is band-limited. Never changed after it has been published.
+struct WavetableSet
+{
+    static constexpr int tableSize = 2048;
+    static constexpr int numOctaves = 10;
+    static constexpr double lowestFrequency = 20.0;     // start of the first octave
+
+    const float* getTable(double frequency) const;      // table for a fundamental in Hz
+
+    int version = 0;                                    // request this set was baked for
+    double sampleRate = 0.0;
+    float samples[numOctaves][tableSize + 1];           // last sample repeats the first
+};
+
+// Bakes wavetables from harmonic gains on a background thread and hands them
+// to the audio thread without locks. requestBake() neither allocates nor
+// locks and may be called from any one thread at a time, including the audio
+// thread. It doesn't wake the baker, signalling a thread takes a lock; the
+// baker looks for new requests every pollInterval instead.
+class WavetableBank : private Thread {
+
+public:
+    WavetableBank();
+    ~WavetableBank() override;
+
+    static constexpr int maxHarmonics = 1024;
+    static constexpr int pollInterval = 10;     // ms, at most this much later than the request a bake starts
+
+    void prepare(double sampleRate);
+    void requestBake(const vector<double>& gainVector);
+    void requestBake(const double* gains, int numHarmonics);
+
+    // Audio thread, once per block. Returns nullptr while the latest request
+    // is still being baked, so voices fall back to additive rendering.
+    const WavetableSet* getCurrentSet();
+
+private:
+    void run() override;
+    void bake();
+    void freeRetiredSets();
+
+    // Latest request, written and read as a seqlock
+    array<atomic<float>, maxHarmonics> pendingGains;
+    atomic<int> pendingNumHarmonics { 0 };
+    atomic<int> pendingSequence { 0 };      // odd while a request is being written
+    atomic<int> requestedVersion { 0 };
+    atomic<double> sampleRate { 44100.0 };
+
+    atomic<WavetableSet*> currentSet { nullptr };
+    atomic<int64> audioBlockCount { 0 };    // bumped by getCurrentSet()
+
+    // Sets that were replaced, deleted once the audio thread can't use them
+    struct RetiredSet
+    {
+        WavetableSet* set;
+        int64 blockCount;
+    };
+    vector<RetiredSet> retiredSets;         // baker thread only
+
+    dsp::FFT fft { 11 };                    // one cycle of tableSize samples
+    vector<float> fftBuffer;
+
+    JUCE_DECLARE_NON_COPYABLE(WavetableBank)
+};